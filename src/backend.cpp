@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "backend.h"
+#include "topology.h"
+#include "my_timer.cpp"
+
+
+// Throws std::invalid_argument if thr_n is not a worker
+void Backend::check_worker(int thr_n) const {
+
+    if (thr_n < 0 || thr_n >= workers())
+        throw std::invalid_argument("the backend has no worker " + std::to_string(thr_n));
+}
+
+
+// Phases are supported only by the backends that start every phase from the caller
+int Backend::run_blocks(int, int, int, const block_fn &, const block_fn &, const sweep_fn &, const end_fn &) {
+    throw std::invalid_argument("the backend cannot read A one block at a time");
+}
+
+
+SequentialBackend::SequentialBackend(int stats) : n(0), stats(stats) {}
+
+void SequentialBackend::prepare(int n) {
+    this->n = n;
+}
+
+std::vector<row_range> SequentialBackend::worker_rows(int thr_n) const {
+
+    check_worker(thr_n);
+    return {{0, n}};
+}
+
+// Execute the iterations on the calling thread
+int SequentialBackend::run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    norms.assign(width, norm_partial());
+    norm_partial *normp = width != 0 ? norms.data() : nullptr;
+
+    if (stats == 0) {
+        for (int k = 1; k <= n_iter; k++) {
+            std::fill(norms.begin(), norms.end(), norm_partial());
+            sweep(0, n, normp);
+            if (end_iteration(norms, 1))
+                return k;
+        }
+        return n_iter;
+    }
+
+    // Instantiate a timer to measure the time needed to execute an iteration of the for loops.
+    my_timer iter_timer;
+    // Instantiate a timer to measure the time needed to execute the operations that cannot be parallelized
+    my_timer seq_timer;
+
+    // The backend can measure the elapsed time of different components based on the value of the attribute stats. The
+    // code below prints what it is measuring
+    if (stats == 1)
+        std::cout << "Stats is equal to 1. Printing time required to compute an iteration of the while loop..." << std::endl;
+    else if (stats == 2)
+        std::cout << "Stats is equal to 2. Printing time required to compute an iteration of the internal for loop..." << std::endl;
+
+    for (int k = 1; k <= n_iter; k++) {
+        std::fill(norms.begin(), norms.end(), norm_partial());
+
+        // If stats is equal to 1 the timer measures the elapsed to execute one iteration of the while loop
+        if (stats == 1) {
+            iter_timer.start_timer();
+            sweep(0, n, normp);
+            std::cout << iter_timer.get_time() << std::endl;
+        }
+        // If stats is equal to 2 the timer measures the elapsed to execute one iteration of the internal for loop, the
+        // rows are computed one at a time
+        else {
+            for (int i = 0; i < n; i++) {
+                iter_timer.start_timer();
+                sweep(i, i + 1, normp);
+                std::cout << iter_timer.get_time() << std::endl;
+            }
+        }
+
+        // measure the elapsed time to execute the operations that cannot be parallelized
+        seq_timer.start_timer();
+        if (end_iteration(norms, 1))
+            return k;
+        std::cout << "sequential ops " << seq_timer.get_time() << std::endl;
+    }
+    return n_iter;
+}
+
+
+// Start the threads
+BarrierBackend::BarrierBackend(int nw, const std::string &barrier_kind, int spin, partition_kind part, int bsize,
+                               const std::vector<int> &thread_cpus, bool stats) :
+        nw(nw), n(-1), part(part), bsize(bsize), stats(stats), thread_cpus(thread_cpus), rows(nw), iter_time(nw),
+        solves(0), active(0), is_done(false) {
+
+    measured.wait_time.assign(nw, 0);
+    measured.ex_time.assign(nw, 0);
+
+    // The barrier lives as long as the threads, its completion function ends the current iteration
+    bar = make_barrier(barrier_kind, nw, [this]() { end_of_iteration(); }, spin, thread_cpus);
+
+    for (int i = 0; i < nw; i++)
+        threads.emplace_back(&BarrierBackend::worker, this, i);
+}
+
+// Wake the threads to terminate them
+BarrierBackend::~BarrierBackend() {
+
+    is_done = true;
+    solves.fetch_add(1, std::memory_order_release);
+    solves.notify_all();
+    for (std::thread &thr : threads)
+        thr.join();
+}
+
+// Split the rows among the threads, the partition does not change between the iterations
+void BarrierBackend::prepare(int n) {
+
+    if (n == this->n)
+        return;
+    this->n = n;
+    for (int i = 0; i < nw; i++)
+        rows[i] = thread_rows(n, nw, i, part, bsize);
+}
+
+std::vector<row_range> BarrierBackend::worker_rows(int thr_n) const {
+
+    check_worker(thr_n);
+    return rows[thr_n];
+}
+
+// Completion function of the barrier, executed by the last thread of every iteration
+void BarrierBackend::end_of_iteration() {
+
+    // At the end of each iteration, update the total waiting time and the total execution time of each thread
+    if (stats)
+        barrier_elapsed_time(iter_time, measured.wait_time, measured.ex_time);
+
+    k++;
+    stop = (*end_iteration)(norms, nw) || k >= n_iter;
+}
+
+// Body of the threads
+void BarrierBackend::worker(int thr_n) {
+
+    if (!thread_cpus.empty())
+        pin_thread(thread_cpus[thr_n]);
+
+    // This timer measures the time needed by the thread to compute its rows in an iteration
+    my_timer iter_timer;
+    long seen = 0;
+
+    while (true) {
+        // The thread sleeps until a new solve starts or the backend is destroyed
+        solves.wait(seen, std::memory_order_acquire);
+        seen = solves.load(std::memory_order_acquire);
+        if (is_done)
+            return;
+
+        norm_partial *normp = width != 0 ? &norms[thr_n * width] : nullptr;
+        do {
+            if (stats)
+                iter_timer.start_timer();
+
+            std::fill(norms.begin() + thr_n * width, norms.begin() + (thr_n + 1) * width, norm_partial());
+            for (const row_range &r : rows[thr_n])
+                (*sweep)(r.first, r.last, normp);
+
+            if (stats)
+                iter_time[thr_n].value = iter_timer.get_time();
+
+            // Waiting the other threads...
+            bar->arrive_and_wait(thr_n);
+        } while (!stop);
+
+        // the last access to the state of the solve, which may be changed by the caller right after
+        if (active.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            active.notify_one();
+    }
+}
+
+// Wake the threads for a new solve and wait for them
+int BarrierBackend::run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    if (n_iter <= 0)
+        return 0;
+
+    this->n_iter = n_iter;
+    this->width = width;
+    this->sweep = &sweep;
+    this->end_iteration = &end_iteration;
+    k = 0;
+    stop = false;
+    norms.assign((std::size_t) nw * width, norm_partial());
+
+    active.store(nw, std::memory_order_relaxed);
+    solves.fetch_add(1, std::memory_order_release);
+    solves.notify_all();
+
+    int r;
+    while ((r = active.load(std::memory_order_acquire)) != 0)
+        active.wait(r, std::memory_order_acquire);
+
+    return k;
+}
@@ -0,0 +1,165 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "kernels.h"
+#include "barrier.h"
+#include "partition.h"
+#include "utils.h"
+
+
+// Computes the rows first ... last - 1 of an iteration. If norms is not null the rows add their contributions to the
+// stopping criterion to the width slots norms[0] ... norms[width - 1] (width is passed to Backend::run)
+using sweep_fn = std::function<void(int first, int last, norm_partial *norms)>;
+
+// Called by a single thread at the end of every iteration, after every row has been computed and before the next
+// iteration starts. partials holds the partial sums of the iteration: nparts blocks of width slots (the slot c of the
+// part t is partials[t*width + c]), empty if width is 0. Returns true to stop the iterations
+using end_fn = std::function<bool(const std::vector<norm_partial> &partials, int nparts)>;
+
+// Called before and after the phase of every block of rows of an iteration (Backend::run_blocks)
+using block_fn = std::function<void(int block)>;
+
+// Times (microseconds) measured by a backend with the statistics enabled, summed over the solves. The vectors have an
+// element for each worker
+struct backend_times {
+    // time spent waiting for the other workers or for new rows
+    std::vector<time_t> wait_time;
+    // time spent computing rows
+    std::vector<time_t> ex_time;
+    // time spent by the caller to start the phases of the iterations (refill of the task queue)
+    time_t refill = 0;
+};
+
+
+// Execution of the Jacobi iterations on a set of workers, owned by a JacobiSolver and reused by all its solves: the
+// workers are created once by the constructor of the backend. A backend splits the rows of every iteration among its
+// workers (sweep), reduces their partial sums of the stopping criterion and synchronizes the workers at the end of
+// every iteration, where the serial end_iteration is executed
+class Backend {
+protected:
+    backend_times measured;
+
+    // Throws std::invalid_argument if thr_n is not the number of a worker
+    void check_worker(int thr_n) const;
+
+public:
+    virtual ~Backend() = default;
+
+    // Number of workers
+    virtual int workers() const = 0;
+
+    // Split n rows among the workers, called before the rows of A are touched (first_touch) and by every solve. Does
+    // nothing if the rows are already split for n
+    virtual void prepare(int n) = 0;
+
+    // Version of prepare for a sparse A, a backend may balance the parts by the nonzero elements of the rows
+    virtual void prepare(const SparseMatrix &a) { prepare(a.rows()); }
+
+    // Rows that the worker thr_n (0 ... workers() - 1) computes at every iteration after prepare (the rows it computes
+    // first, if the rows are scheduled dynamically)
+    virtual std::vector<row_range> worker_rows(int thr_n) const = 0;
+
+    // Execute at most n_iter iterations on the rows split by prepare: the rows of every iteration are computed by
+    // sweep, then end_iteration is called. Returns the number of iterations executed
+    virtual int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) = 0;
+
+    // Version of run for a matrix read one block of block_rows rows at a time: every iteration has a phase for each
+    // block, begin_block and end_block are called by the caller around the phase. The rows of a block are a multiple
+    // of the parts of the rows. Throws std::invalid_argument if the backend does not support phases
+    virtual int run_blocks(int n_iter, int width, int block_rows, const block_fn &begin_block,
+                           const block_fn &end_block, const sweep_fn &sweep, const end_fn &end_iteration);
+
+    // Times measured by the workers, if the statistics are enabled
+    const backend_times &times() const { return measured; }
+};
+
+
+// The calling thread computes all the rows. With stats == 1 the time of every iteration (and of its serial part) is
+// printed, with stats == 2 the time of every row, computed one at a time
+class SequentialBackend : public Backend {
+private:
+    int n;
+    int stats;
+    std::vector<norm_partial> norms;
+
+public:
+    explicit SequentialBackend(int stats = 0);
+
+    int workers() const override { return 1; }
+    void prepare(int n) override;
+    std::vector<row_range> worker_rows(int thr_n) const override;
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override;
+};
+
+
+// nw threads compute a static partition of the rows (partition.h) and wait each other on a barrier (barrier.h) at the
+// end of every iteration, the last thread to arrive executes end_iteration. Between the solves the threads sleep on
+// an atomic counter of the solves. With stats the execution and waiting times of every thread are measured at every
+// iteration
+class BarrierBackend : public Backend {
+private:
+    int nw;
+    int n;
+    partition_kind part;
+    int bsize;
+    bool stats;
+    std::vector<int> thread_cpus;
+
+    // rows of each thread
+    std::vector<std::vector<row_range>> rows;
+
+    // state of the current solve, set by the caller before the threads are woken up
+    int n_iter;
+    int width;
+    int k;
+    bool stop;
+    const sweep_fn *sweep;
+    const end_fn *end_iteration;
+
+    // partial sums of the stopping criterion, width slots for each thread
+    std::vector<norm_partial> norms;
+    // execution time of each thread in the current iteration
+    std::vector<padded<time_t>> iter_time;
+
+    std::unique_ptr<Barrier> bar;
+
+    // Number of solves started, the threads wait on it for a new solve. active counts the threads that have not
+    // finished the current solve yet, the caller waits on it
+    alignas(64) std::atomic<long> solves;
+    alignas(64) std::atomic<int> active;
+    bool is_done;
+
+    std::vector<std::thread> threads;
+
+    // Body of the threads
+    void worker(int thr_n);
+
+    // Completion function of the barrier
+    void end_of_iteration();
+
+public:
+    // Start nw threads, the i-th one pinned on thread_cpus[i] (if it is not empty). barrier_kind and spin select the
+    // barrier (make_barrier), part and bsize the partitioning of the rows
+    BarrierBackend(int nw, const std::string &barrier_kind, int spin, partition_kind part, int bsize,
+                   const std::vector<int> &thread_cpus, bool stats = false);
+
+    ~BarrierBackend();
+
+    BarrierBackend(const BarrierBackend&) = delete;
+    BarrierBackend& operator=(const BarrierBackend&) = delete;
+
+    int workers() const override { return nw; }
+    void prepare(int n) override;
+    std::vector<row_range> worker_rows(int thr_n) const override;
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override;
+};
+
+#endif
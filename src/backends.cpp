@@ -0,0 +1,44 @@
+#include <stdexcept>
+
+#include "backends.h"
+#include "task_queue.h"
+#include "omp_backend.h"
+#include "pstl_backend.h"
+#include "barrier.h"
+#ifdef JACOBI_FASTFLOW
+#include "ff_backend.h"
+#endif
+
+
+std::vector<std::string> backend_names() {
+    std::vector<std::string> names = {"seq", "barrier", "tasks", "omp", "pstl"};
+#ifdef JACOBI_FASTFLOW
+    names.push_back("ff");
+#endif
+    return names;
+}
+
+// The FastFlow backend is compiled only with -DJACOBI_FASTFLOW, since it needs the headers of FastFlow
+std::unique_ptr<Backend> make_backend(const std::string &kind, const backend_config &cfg) {
+
+    if (kind == "seq")
+        return std::make_unique<SequentialBackend>();
+    if (kind == "barrier") {
+        int spin = cfg.spin < 0 ? default_spin(cfg.nw) : cfg.spin;
+        return std::make_unique<BarrierBackend>(cfg.nw, cfg.barrier_kind, spin, cfg.part, cfg.bsize, cfg.thread_cpus,
+                                                cfg.stats);
+    }
+    if (kind == "tasks")
+        return std::make_unique<TaskQueue>(cfg.nw, cfg.chunk > 0 ? cfg.chunk : DEFAULT_CHUNK, cfg.thread_cpus,
+                                           cfg.stats, parse_chunk_schedule(cfg.schedule));
+    if (kind == "omp")
+        return std::make_unique<OmpBackend>(cfg.nw, parse_omp_schedule(cfg.schedule), cfg.chunk, cfg.thread_cpus);
+    if (kind == "pstl")
+        return std::make_unique<PstlBackend>(cfg.nw, cfg.chunk);
+#ifdef JACOBI_FASTFLOW
+    if (kind == "ff")
+        return std::make_unique<FastFlowBackend>(cfg.nw, cfg.chunk, cfg.spin_wait);
+#endif
+
+    throw std::invalid_argument("unknown backend " + kind);
+}
@@ -0,0 +1,46 @@
+#ifndef BACKENDS_H
+#define BACKENDS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend.h"
+#include "partition.h"
+
+
+// Rows of a chunk of the task queue when the program does not specify them
+constexpr int DEFAULT_CHUNK = 256;
+
+// Parameters of the backends, every backend reads only its own ones
+struct backend_config {
+    // parallel degree and cpus of the threads (affinity_cpus)
+    int nw = 1;
+    std::vector<int> thread_cpus;
+
+    // barrier backend: barrier (make_barrier), spin iterations (< 0 for default_spin) and partitioning of the rows
+    std::string barrier_kind = "spin";
+    int spin = -1;
+    partition_kind part = partition_kind::block;
+    int bsize = DEFAULT_BSIZE;
+
+    // rows of a chunk of the task queue (0 for DEFAULT_CHUNK), of the OpenMP, parallel STL and FastFlow backends
+    // (0 for static scheduling, nw contiguous ranges of rows)
+    int chunk = 0;
+    // schedule of the OpenMP backend (static, dynamic, guided) or of the chunks of the task queue (static, guided,
+    // adaptive)
+    std::string schedule = "static";
+    // the workers of the FastFlow backend spin between the iterations
+    bool spin_wait = false;
+
+    // measure the times of the workers (barrier and tasks backends)
+    bool stats = false;
+};
+
+// Names of the backends available in this program (seq, barrier, tasks, omp, pstl and ff if built with FastFlow)
+std::vector<std::string> backend_names();
+
+// Create the backend called kind, throws std::invalid_argument if it does not exist or is not available
+std::unique_ptr<Backend> make_backend(const std::string &kind, const backend_config &cfg);
+
+#endif
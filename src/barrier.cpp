@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "barrier.h"
+#include "utils.h"
+#include "topology.h"
+
+
+StdBarrier::StdBarrier(int nw, std::function<void()> completion) : completion(std::move(completion)),
+                                                                    bar(nw, completion_call{&this->completion}) {}
+
+void StdBarrier::arrive_and_wait(int) {
+    bar.arrive_and_wait();
+}
+
+
+// Spin iterations used when the program does not specify them
+int default_spin(int nw) {
+
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw != 0 && (unsigned) nw > hw ? 0 : DEFAULT_SPIN;
+}
+
+
+// Wait until the value of generation is different from gen
+void spin_then_park(std::atomic<unsigned> &generation, unsigned gen, std::atomic<int> &parked, int spin) {
+
+    // spin with exponential backoff, the pause instructions leave the pipeline (and the other hyperthread) free
+    int pause = 1;
+    for (int i = 0; i < spin; i += pause) {
+        if (generation.load(std::memory_order_acquire) != gen)
+            return;
+        for (int p = 0; p < pause; p++)
+            cpu_relax();
+        if (pause < 64)
+            pause <<= 1;
+    }
+
+    // park the thread
+    parked.fetch_add(1, std::memory_order_seq_cst);
+    while (generation.load(std::memory_order_seq_cst) == gen)
+        generation.wait(gen, std::memory_order_acquire);
+    parked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Change the value of generation and wake the parked threads
+void release_waiters(std::atomic<unsigned> &generation, unsigned gen, std::atomic<int> &parked) {
+
+    generation.store(gen, std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_seq_cst) > 0)
+        generation.notify_all();
+}
+
+
+SpinBarrier::SpinBarrier(int nw, std::function<void()> completion, int spin) : count(nw), generation(0), parked(0),
+                                                                               nw(nw), spin(spin),
+                                                                               completion(std::move(completion)) {}
+
+void SpinBarrier::arrive_and_wait(int) {
+
+    unsigned gen = generation.load(std::memory_order_acquire);
+
+    if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // last thread: execute the completion function and release the other threads
+        completion();
+        count.store(nw, std::memory_order_relaxed);
+        release_waiters(generation, gen + 1, parked);
+        return;
+    }
+
+    spin_then_park(generation, gen, parked, spin);
+}
+
+
+TreeBarrier::TreeBarrier(int nw, std::function<void()> completion, int spin, const std::vector<int> &thread_cpus)
+                         : leaf(nw), spin(spin), completion(std::move(completion)) {
+
+    // Group the threads by the (socket, last level cache) of their cpu
+    std::vector<cpu_info> cpus = available_cpus();
+    std::map<std::pair<int, int>, std::vector<int>> domains;
+    for (int i = 0; i < nw; i++) {
+        std::pair<int, int> domain(0, 0);
+        for (const cpu_info &info : cpus)
+            if (info.cpu == thread_cpus[i])
+                domain = std::make_pair(info.package, info.llc);
+        domains[domain].push_back(i);
+    }
+
+    // Build the tree level by level: the items of a level (threads for the first level, nodes otherwise) are combined
+    // in groups of TREE_FAN_IN, each group becomes a node of the next level
+    std::vector<int> parent, fan_in;
+    auto combine = [&](std::vector<int> items, bool threads) {
+        int height = 0;
+        while (threads || items.size() > 1) {
+            std::vector<int> next;
+            for (std::size_t g = 0; g < items.size(); g += TREE_FAN_IN) {
+                int id = parent.size();
+                parent.push_back(-1);
+                fan_in.push_back(std::min<int>(TREE_FAN_IN, items.size() - g));
+                for (std::size_t c = g; c < g + fan_in[id]; c++) {
+                    if (threads)
+                        leaf[items[c]] = id;
+                    else
+                        parent[items[c]] = id;
+                }
+                next.push_back(id);
+            }
+            items = next;
+            threads = false;
+            height++;
+        }
+        return std::make_pair(items[0], height);
+    };
+
+    std::vector<int> roots;
+    int max_height = 0;
+    for (auto &domain : domains) {
+        auto [root, height] = combine(domain.second, true);
+        roots.push_back(root);
+        max_height = std::max(max_height, height);
+    }
+    depth = max_height + combine(roots, false).second;
+    if (depth > MAX_DEPTH)
+        throw std::invalid_argument("too many threads for the tree barrier");
+
+    nodes = std::make_unique<node[]>(parent.size());
+    for (std::size_t i = 0; i < parent.size(); i++) {
+        nodes[i].count.store(fan_in[i], std::memory_order_relaxed);
+        nodes[i].fan_in = fan_in[i];
+        nodes[i].parent = parent[i];
+        nodes[i].generation.store(0, std::memory_order_relaxed);
+        nodes[i].parked.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TreeBarrier::arrive_and_wait(int thr_n) {
+
+    // nodes completed by the thread, with their generation
+    std::pair<int, unsigned> climbed[MAX_DEPTH];
+    int top = 0;
+
+    int id = leaf[thr_n];
+    while (true) {
+        node &nd = nodes[id];
+        unsigned gen = nd.generation.load(std::memory_order_acquire);
+
+        if (nd.count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            // not the last thread of the node: wait to be released by the thread that has completed it
+            spin_then_park(nd.generation, gen, nd.parked, spin);
+            break;
+        }
+
+        // last thread of the node: nobody can arrive again on it until it is released
+        nd.count.store(nd.fan_in, std::memory_order_relaxed);
+        climbed[top++] = std::make_pair(id, gen);
+
+        if (nd.parent < 0) {
+            completion();
+            break;
+        }
+        id = nd.parent;
+    }
+
+    // release the nodes completed by the thread, from the top
+    while (top > 0) {
+        top--;
+        release_waiters(nodes[climbed[top].first].generation, climbed[top].second + 1, nodes[climbed[top].first].parked);
+    }
+}
+
+
+// Create the barrier called kind for nw threads
+std::unique_ptr<Barrier> make_barrier(const std::string &kind, int nw, std::function<void()> completion, int spin,
+                                      const std::vector<int> &thread_cpus) {
+
+    if (kind == "std")
+        return std::make_unique<StdBarrier>(nw, std::move(completion));
+    if (kind == "spin")
+        return std::make_unique<SpinBarrier>(nw, std::move(completion), spin);
+    if (kind == "tree")
+        return std::make_unique<TreeBarrier>(nw, std::move(completion), spin,
+                                             thread_cpus.empty() ? default_thread_cpus(nw) : thread_cpus);
+
+    throw std::invalid_argument("unknown barrier " + kind);
+}
@@ -0,0 +1,119 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <atomic>
+#include <barrier>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Barrier used by par_jacobi at the end of each Jacobi iteration. The last thread to arrive executes the completion
+// function before the other threads are released. Every thread passes its own index (0 ... nw - 1)
+class Barrier {
+public:
+    virtual ~Barrier() = default;
+
+    virtual void arrive_and_wait(int thr_n) = 0;
+};
+
+
+// Wrapper of std::barrier
+class StdBarrier : public Barrier {
+private:
+    // std::barrier requires a completion function that does not throw
+    struct completion_call {
+        std::function<void()> *f;
+        void operator()() noexcept { (*f)(); }
+    };
+
+    std::function<void()> completion;
+    std::barrier<completion_call> bar;
+
+public:
+    StdBarrier(int nw, std::function<void()> completion);
+
+    void arrive_and_wait(int thr_n) override;
+};
+
+
+// Sense-reversing centralized barrier. The waiting threads spin on the generation number (with pause and exponential
+// backoff) for spin iterations, then they park on atomic::wait (futex), so a short wait costs no system call while a
+// long wait does not burn the CPU. The last thread executes the completion function and reverses the sense (i.e.
+// increments the generation number)
+class SpinBarrier : public Barrier {
+private:
+    alignas(64) std::atomic<int> count;
+    alignas(64) std::atomic<unsigned> generation;
+    std::atomic<int> parked;
+
+    int nw;
+    int spin;
+    std::function<void()> completion;
+
+public:
+    SpinBarrier(int nw, std::function<void()> completion, int spin);
+
+    void arrive_and_wait(int thr_n) override;
+};
+
+
+// Hierarchical combining-tree barrier. The threads are grouped by the last level cache (and socket) of the cpu they run
+// on, every group gets its own subtree with fan-in TREE_FAN_IN and the roots of the subtrees are combined up to a single
+// root. A thread arrives on its leaf: if it is not the last one of the node it waits on the node (spin then park),
+// otherwise it climbs to the parent. The thread completing the root executes the completion function and releases
+// the nodes it has climbed, whose last threads release their own nodes: every counter and flag is shared only by a
+// few threads of the same cache domain, and only the roots of the subtrees cross the sockets
+class TreeBarrier : public Barrier {
+private:
+    struct alignas(64) node {
+        alignas(64) std::atomic<int> count;
+        int fan_in;
+        int parent;
+        alignas(64) std::atomic<unsigned> generation;
+        std::atomic<int> parked;
+    };
+
+    std::unique_ptr<node[]> nodes;
+    // leaf of each thread
+    std::vector<int> leaf;
+    // depth of the tree
+    int depth;
+    static constexpr int MAX_DEPTH = 32;
+
+    int spin;
+    std::function<void()> completion;
+
+public:
+    // thread_cpus[i] is the cpu on which the i-th thread runs
+    TreeBarrier(int nw, std::function<void()> completion, int spin, const std::vector<int> &thread_cpus);
+
+    void arrive_and_wait(int thr_n) override;
+};
+
+// Number of children of every node of TreeBarrier
+constexpr int TREE_FAN_IN = 4;
+
+
+// Default number of spin iterations before a thread parks
+constexpr int DEFAULT_SPIN = 20000;
+
+// Spin iterations used when the program does not specify them: DEFAULT_SPIN, or 0 if there are more threads than
+// hardware threads (spinning would only steal the CPU from the threads that the others are waiting for)
+int default_spin(int nw);
+
+// Wait until the value of generation is different from gen: spin for (about) spin iterations, then park. parked counts
+// the parked threads, so that the thread changing generation can skip the system call when nobody is parked
+void spin_then_park(std::atomic<unsigned> &generation, unsigned gen, std::atomic<int> &parked, int spin);
+
+// Change the value of generation to gen and wake the threads waiting on it in spin_then_park
+void release_waiters(std::atomic<unsigned> &generation, unsigned gen, std::atomic<int> &parked);
+
+// Create the barrier called kind ("std", "spin" or "tree") for nw threads. thread_cpus[i] is the cpu on which the i-th
+// thread runs (used by the tree barrier), if it is empty the threads are assumed to run on the cpus returned by
+// default_thread_cpus
+std::unique_ptr<Barrier> make_barrier(const std::string &kind, int nw, std::function<void()> completion,
+                                      int spin = DEFAULT_SPIN, const std::vector<int> &thread_cpus = {});
+
+#endif
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <barrier>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "stencil.h"
+#include "kernels.h"
+#include "utils.h"
+#include "my_timer.cpp"
+
+#define MAX_VALUE 32
+#define MIN_VALUE -32
+
+
+// Time (in microseconds) of sweeps sweeps of the stencil a computed by nw threads, every thread computes a static
+// block of rows and every iteration performs a.time_block() sweeps
+static time_t run_sweeps(const StencilMatrix &a, std::vector<float> &b, int sweeps, int nw) {
+
+    int n = a.rows();
+    aligned_vector x(n, 0.0f);
+    aligned_vector xo(n, 0.0f);
+    int n_iter = sweeps / a.time_block();
+
+    std::barrier bar(nw, [&]() noexcept { xo.swap(x); });
+
+    auto worker = [&](int thr_n) {
+        int first = (int) ((long long) n * thr_n / nw);
+        int last = (int) ((long long) n * (thr_n + 1) / nw);
+        for (int k = 0; k < n_iter; k++) {
+            jacobi_rows(a, b.data(), xo.data(), x.data(), first, last);
+            bar.arrive_and_wait();
+        }
+    };
+
+    my_timer timer;
+    timer.start_timer();
+
+    std::vector<std::thread> tvec(nw);
+    for (int i = 0; i < nw; i++)
+        tvec[i] = std::thread(worker, i);
+    for (std::thread &thr : tvec)
+        thr.join();
+
+    return timer.get_time();
+}
+
+// Throughput of the stencil kernel (grid points updated per second) with and without temporal blocking
+int main(int argc, char *argv[]) {
+
+    int side = std::stoul(argv[1]); //points in every dimension of the grid
+    int dims = std::stoul(argv[2]); //dimensions of the grid (2 or 3)
+    int sweeps = std::stoul(argv[3]); //Jacobi sweeps of every run, rounded down to a multiple of the time block
+    int nw = std::stoul(argv[4]); //parallel degree
+    std::string tblocks = get_option(argc, argv, "tblocks", "1,2,4,8"); //time blocks to measure, separated by commas
+    int seed = std::stoul(get_option(argc, argv, "seed", "1")); //seed to generate b
+
+    int n = StencilMatrix::points(dims, side);
+    std::vector<float> b(n);
+    StencilMatrix a0(dims, side);
+    initialize_problem(n, std::ref(a0), std::ref(b), MIN_VALUE, MAX_VALUE, seed, nw);
+
+    std::cout << "grid points " << n << ", halo " << a0.halo() << ", tile " << STENCIL_TILE << std::endl;
+
+    std::stringstream list(tblocks);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        StencilMatrix a(dims, side, std::stoul(item));
+        int s = std::max(1, sweeps / a.time_block()) * a.time_block();
+
+        // a first run of one iteration touches the vectors before the measure
+        run_sweeps(a, b, a.time_block(), nw);
+        time_t t = run_sweeps(a, b, s, nw);
+
+        double updates = (double) n * s / (t > 0 ? t : 1) * 1e6;
+        std::cout << "tblock " << a.time_block() << ": " << s << " sweeps in " << t << " us, " << updates / 1e9
+                  << " Gupdates/s" << std::endl;
+    }
+
+    return 0;
+}
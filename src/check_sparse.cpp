@@ -0,0 +1,62 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "partition.h"
+#include "kernels.h"
+#include "utils.h"
+
+#define MAX_VALUE 32
+#define MIN_VALUE -32
+
+// Check that the sparse kernel writes exactly the rows of its range, for every range of the cyclic partitioning (the
+// shortest ranges, which begin and end inside the windows of sell) and of the block partitioning. A row written by the
+// sweep of another thread makes the parallel programs nondeterministic. The return code is the number of ranges that
+// failed
+int main() {
+
+    // sizes with a partial last window (and a partial last slice) and without
+    std::vector<int> sizes = {1000, 1003, 1021, 1024, 300, 37};
+    std::vector<int> degrees = {2, 3, 7};
+    int failed = 0;
+
+    for (std::string format : {"csr", "sell"})
+        for (int n : sizes) {
+            SparseMatrix a(n, 16);
+            std::vector<float> b(n);
+            initialize_problem(n, a, b, MIN_VALUE, MAX_VALUE, 1);
+            if (format == "sell")
+                a.to_sell();
+
+            aligned_vector xo(n), x(n);
+            for (int i = 0; i < n; i++)
+                xo[i] = (float) (i % 7) - 3.0f;
+
+            for (int nw : degrees)
+                for (partition_kind part : {partition_kind::cyclic, partition_kind::block})
+                    for (int t = 0; t < nw; t++)
+                        for (row_range r : thread_rows(n, nw, t, part)) {
+                            // the rows not written keep the sentinel
+                            std::fill(x.begin(), x.end(), NAN);
+                            jacobi_rows(a, b.data(), xo.data(), x.data(), r.first, r.last);
+
+                            bool ok = true;
+                            for (int i = 0; i < n; i++)
+                                ok = ok && (i >= r.first && i < r.last) != std::isnan(x[i]);
+                            if (!ok) {
+                                std::cout << "FAILED " << format << " n=" << n << " nw=" << nw << " rows "
+                                          << r.first << "-" << r.last << std::endl;
+                                failed++;
+                            }
+                        }
+        }
+
+    if (failed == 0)
+        std::cout << "sparse kernel: every range writes only its own rows" << std::endl;
+    return failed;
+}
@@ -0,0 +1,105 @@
+#ifndef FF_BACKEND_H
+#define FF_BACKEND_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <ff/ff.hpp>
+#include <ff/parallel_for.hpp>
+
+#include "backend.h"
+
+
+// Backend built on the ParallelForReduce of FastFlow (par_jacobi_ff): every iteration is a parallel loop over the rows
+// with chunks of chunk_size rows (0 means static scheduling, nw contiguous blocks). With a single slot of the stopping
+// criterion the loop is a parallel_reduce, the workers update the rows and sum the partial norms in the same pass and
+// FastFlow combines them, otherwise (a batch of right-hand sides) every worker writes its own slots. The object and its
+// threads are created once by the constructor and reused by all the iterations and the solves; with spin_wait the
+// workers spin between the iterations instead of sleeping and the loops are scheduled by the workers themselves
+// (disableScheduler), which removes most of the cost of an iteration at small n. Header only, since only the programs
+// built with FastFlow use it
+class FastFlowBackend : public Backend {
+private:
+    int nw;
+    int n;
+    int chunk_size;
+    ff::ParallelForReduce<norm_partial> pf;
+
+    // partial sums of the stopping criterion, width slots for each worker
+    std::vector<norm_partial> norms;
+
+public:
+    FastFlowBackend(int nw, int chunk_size, bool spin_wait = false) : nw(nw), n(0), pf(nw, spin_wait, spin_wait) {
+        // The chunks are multiples of the blocks of rows computed together by the kernel
+        this->chunk_size = chunk_size > 0 ? round_to_block(chunk_size) : 0;
+        if (spin_wait)
+            pf.disableScheduler(true);
+    }
+
+    int workers() const override { return nw; }
+
+    void prepare(int n) override { this->n = n; }
+
+    // The rows of the static scheduling of the ParallelFor: nw contiguous blocks if chunk_size == 0, otherwise chunks
+    // assigned in a round-robin way (the dynamic scheduler may move some of them)
+    std::vector<row_range> worker_rows(int thr_n) const override {
+        check_worker(thr_n);
+        std::vector<row_range> rows;
+        if (chunk_size == 0)
+            rows.push_back({(int) ((long) n * thr_n / nw), (int) ((long) n * (thr_n + 1) / nw)});
+        else
+            for (long j = (long) thr_n * chunk_size; j < n; j += (long) nw * chunk_size)
+                rows.push_back({(int) j, (int) std::min<long>(j + chunk_size, n)});
+        return rows;
+    }
+
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override {
+
+        if (width == 1)
+            return run_reduce(n_iter, sweep, end_iteration);
+
+        norms.assign((std::size_t) nw * width, norm_partial());
+
+        // This function has to be executed by the ParallelFor object at each Jacobi iteration, it computes the rows
+        // start ... end - 1
+        std::function<void(const long, const long, const int)> f = [&](const long start, const long end,
+                                                                         const int thid) {
+            sweep(start, end, width != 0 ? &norms[(std::size_t) thid * width] : nullptr);
+        };
+
+        for (int k = 1; k <= n_iter; k++) {
+            std::fill(norms.begin(), norms.end(), norm_partial());
+            pf.parallel_for_idx(0, n, 1, chunk_size, f);
+            if (end_iteration(norms, nw))
+                return k;
+        }
+        return n_iter;
+    }
+
+private:
+    // Iterations with a single slot of the stopping criterion: the partial sums of every worker are reduced by FastFlow
+    // in norms[0]
+    int run_reduce(int n_iter, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+        norms.assign(1, norm_partial());
+
+        auto body = [&](const long start, const long end, norm_partial &part, const int) {
+            sweep(start, end, &part);
+        };
+        auto combine = [](norm_partial &total, const norm_partial &part) {
+            total.num += part.num;
+            total.den += part.den;
+        };
+
+        for (int k = 1; k <= n_iter; k++) {
+            norms[0] = norm_partial();
+            pf.parallel_reduce_idx(norms[0], norm_partial(), 0, n, 1, chunk_size, body, combine);
+            if (end_iteration(norms, 1))
+                return k;
+        }
+        return n_iter;
+    }
+};
+
+#endif
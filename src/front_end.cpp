@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include <stdexcept>
+
+#include "front_end.h"
+#include "implicit_matrix.h"
+#include "sparse_matrix.h"
+#include "reorder.h"
+#include "stencil.h"
+#include "rhs_batch.h"
+#include "stream.h"
+#include "topology.h"
+#include "my_timer.cpp"
+
+#define MAX_VALUE 32
+#define MIN_VALUE -32
+
+
+// Parse the arguments shared by the programs and open the system file
+front_end::front_end(int argc, char *argv[], int stream_rows, int stream_multiple) :
+        stream_rows(stream_rows), stream_multiple(stream_multiple) {
+
+    seed = std::stoul(argv[1]); //seed to generate random numbers
+    n = std::stoul(argv[2]); //linear system's dimension
+    opts.n_iter = std::stoul(argv[3]); //maximum number of iterations
+    opts.ch_conv = std::stoul(argv[4]); //if it's 1 the programm will check the convergence of jacobi at each iteration, if it's 0 it will not
+    opts.tol = std::atof(argv[5]); //maximum tolerance for convergence, the program will use this value only if ch_conv == 1
+
+    matrix_kind = get_option(argc, argv, "matrix", "dense"); //dense (A is stored), implicit (A is regenerated at every sweep), csr or sell (sparse A), stencil2d or stencil3d (Poisson problem on a grid of side n)
+    tblock = std::stoul(get_option(argc, argv, "tblock", "1")); //sweeps of the stencil computed at every iteration (temporal blocking)
+    row_nnz = std::stoul(get_option(argc, argv, "row_nnz", "16")); //elements besides the diagonal in every row of the random sparse A (csr, sell)
+    reorder = get_option(argc, argv, "reorder", "none"); //none or rcm (reverse Cuthill-McKee permutation of a sparse A)
+    system_path = get_option(argc, argv, "system", ""); //file of the linear system to solve instead of a random one
+    n_rhs = std::stoul(get_option(argc, argv, "rhs", "1")); //right-hand sides solved together (dense A only), b is the first one
+
+    bool stencil_kind = matrix_kind == "stencil2d" || matrix_kind == "stencil3d";
+    if (matrix_kind != "dense" && matrix_kind != "implicit" && matrix_kind != "csr" && matrix_kind != "sell" &&
+        !stencil_kind)
+        throw std::invalid_argument("unknown matrix " + matrix_kind);
+    // A and b of a system file are stored, as a dense or a sparse A
+    if (!system_path.empty() && (stencil_kind || matrix_kind == "implicit"))
+        throw std::invalid_argument("--system cannot be used with --matrix=" + matrix_kind);
+
+    // If a system file is passed, A and b are read from it and n is the dimension of the system in the file. When A is
+    // streamed the file is not read in advance
+    if (!system_path.empty()) {
+        file = std::make_unique<SystemFile>(system_path, stream_rows == 0);
+        n = file->rows();
+    }
+    if (stream_rows != 0 && (!file || !file->is_dense()))
+        throw std::invalid_argument("--stream requires a dense system file (--system)");
+    if (n_rhs > 1 && (stream_rows != 0 || !(file ? file->is_dense() : matrix_kind == "dense")))
+        throw std::invalid_argument("--rhs requires a dense A");
+
+    // For a stencil the positional n is the side of the grid, the system has n^2 (2D) or n^3 (3D) unknowns
+    side = n;
+    stencil = stencil_kind;
+    if (stencil)
+        n = StencilMatrix::points(matrix_kind == "stencil2d" ? 2 : 3, side);
+}
+
+// Kind of A
+std::string front_end::system_kind() const {
+
+    if (!file)
+        return matrix_kind;
+    return file->is_dense() ? "dense" : matrix_kind == "sell" ? "sell" : "csr";
+}
+
+
+// Create the system, solve it and print the result
+void run_front_end(front_end &fe, JacobiSolver &solver, int gen_nw, const std::vector<int> &thread_cpus,
+                   const front_end_hooks &hooks) {
+
+    int n = fe.n;
+    SystemFile *file = fe.file.get();
+
+    // Creation of vector b
+    std::vector<float> b(n);
+    // Creation of vector x
+    aligned_vector x(n, 0);
+
+    // The program may use the system before the first solve (e.g. to calibrate the backend)
+    auto before_solve = [&](auto &a) {
+        if (hooks.before_solve)
+            hooks.before_solve([&](JacobiSolver &trial, const solve_options &opts) {
+                aligned_vector xt(n, 0);
+                trial.solve(a, b, xt, opts);
+            });
+    };
+
+    auto report = [&](time_t elapsed) {
+        if (hooks.report)
+            hooks.report(elapsed);
+        else
+            std::cout << "Elapsed time: " << elapsed << std::endl;
+    };
+
+    // Solve the system with the matrix A, stored (Matrix), regenerated on the fly (ImplicitMatrix), sparse
+    // (SparseMatrix), a stencil (StencilMatrix) or read one block at a time (BlockStream)
+    auto solve = [&](auto &a) {
+
+        // OPTIONAL, print the system created
+        //print_system(n, std::ref(a), std::ref(b));
+
+
+        before_solve(a);
+
+        // Start to measure the elapsed time
+        my_timer timer;
+        timer.start_timer();
+
+        // Compute Jacobi
+        if (solver.solve(a, b, x, fe.opts).converged)
+            std::cout << "condition for convergence is satisfied" << std::endl;
+
+
+        // Measure the elapsed time and print the result.
+        report(timer.get_time());
+
+
+        // OPTIONAL to check the error
+        //check_error(n, std::ref(a), std::ref(b), std::ref(x));
+    };
+
+    // Solve the systems A X = B of a batch of right-hand sides, the column 0 of B is b (dense A only)
+    auto solve_batch = [&](Matrix &a) {
+
+        RhsBatch batch(n, fe.n_rhs);
+        initialize_rhs(n, batch, b, MIN_VALUE, MAX_VALUE, fe.seed);
+        before_solve(a);
+
+        my_timer timer;
+        timer.start_timer();
+
+        if (solver.solve(a, batch, fe.opts).converged)
+            std::cout << "condition for convergence is satisfied" << std::endl;
+
+        report(timer.get_time());
+
+        // OPTIONAL to check the error of every right-hand side
+        //check_error(n, std::ref(a), std::ref(batch));
+    };
+
+    // A and b are read from the file or generated from the seed
+    if (file && fe.stream_rows != 0) {
+        std::copy(file->b(), file->b() + n, b.begin());
+        BlockStream a(fe.system_path, *file, fe.stream_rows, fe.stream_multiple);
+        solve(a);
+    }
+    else if (file && file->is_dense()) {
+        std::copy(file->b(), file->b() + n, b.begin());
+        Matrix a = file->matrix();
+        if (fe.n_rhs > 1)
+            solve_batch(a);
+        else
+            solve(a);
+    }
+    else if (file || fe.matrix_kind == "csr" || fe.matrix_kind == "sell") {
+        // Sparse A, read from a CSR file or generated with row_nnz elements in every row
+        SparseMatrix a = file ? file->sparse_matrix() : SparseMatrix(n, fe.row_nnz);
+        if (file)
+            std::copy(file->b(), file->b() + n, b.begin());
+        else
+            initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, fe.seed, gen_nw);
+
+        // The unknowns are permuted to move the elements close to the diagonal, the solution is permuted back
+        Reordering reordering = make_reordering(fe.reorder, a);
+        reordering.apply(a, b, x);
+        if (fe.matrix_kind == "sell")
+            a.to_sell();
+        solve(a);
+        reordering.restore(x);
+    }
+    else if (fe.stencil) {
+        // Only b is stored, every iteration performs tblock sweeps
+        StencilMatrix a(fe.matrix_kind == "stencil2d" ? 2 : 3, fe.side, fe.tblock);
+        initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, fe.seed, gen_nw);
+        solve(a);
+    }
+    else if (fe.matrix_kind == "implicit") {
+        ImplicitMatrix a(n);
+        initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, fe.seed, gen_nw);
+        solve(a);
+    }
+    else {
+        // Creation of matrix A
+        Matrix a(n, n);
+
+        // If the threads are pinned, each of them first touches the rows it will compute, so that they are allocated
+        // on its NUMA node
+        solver.backend().prepare(n);
+        std::vector<std::vector<row_range>> rows(solver.backend().workers());
+        for (int i = 0; i < solver.backend().workers(); i++)
+            rows[i] = solver.backend().worker_rows(i);
+        first_touch(std::ref(a), thread_cpus, rows);
+
+        // Initialize the matrices A and b, the threads generate the rows in parallel (the system depends only on the
+        // seed)
+        initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, fe.seed, gen_nw);
+        if (fe.n_rhs > 1)
+            solve_batch(a);
+        else
+            solve(a);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef FRONT_END_H
+#define FRONT_END_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "system_file.h"
+#include "solver.h"
+#include "utils.h"
+
+
+// Arguments and options of the linear system shared by the programs (seq_jacobi, par_jacobi, par_jacobi2,
+// par_jacobi_ff, jacobi): the positional arguments seed, n, n_iter, ch_conv and tol, and the options --matrix,
+// --tblock, --row_nnz, --reorder, --system and --rhs. Every program parses its positional arguments after tol and the
+// options of its backend
+struct front_end {
+    int seed;
+    // dimension of the system: the positional n, the points of the grid of a stencil or the rows of the system file
+    int n;
+    solve_options opts;
+
+    std::string matrix_kind;
+    int tblock;
+    int row_nnz;
+    std::string reorder;
+    std::string system_path;
+    int n_rhs;
+
+    // system file, if any
+    std::unique_ptr<SystemFile> file;
+    // for a stencil the positional n is the side of the grid
+    bool stencil;
+    int side;
+
+    // if not 0, the dense A of the system file is read one block of (about) stream_rows rows at a time (BlockStream),
+    // every block is a multiple of stream_multiple rows
+    int stream_rows;
+    int stream_multiple;
+
+    // Parse the arguments and open the system file, if any. The file is read in advance unless A is streamed (the
+    // programs that support it pass stream_rows). Throws std::invalid_argument if the matrix is unknown or the options
+    // are not compatible (a system file with an implicit A or a stencil)
+    front_end(int argc, char *argv[], int stream_rows = 0, int stream_multiple = 1);
+
+    // Kind of A (dense, implicit, csr, sell, stencil2d, stencil3d): for a system file dense, csr or sell
+    std::string system_kind() const;
+};
+
+// Solve the system of the program from x = 0 with opts on another solver (e.g. a run of the calibration), the
+// solution is discarded
+using trial_fn = std::function<void(JacobiSolver &, const solve_options &)>;
+
+// Functions of a program called by run_front_end
+struct front_end_hooks {
+    // called once before the first solve, when A and b are initialized
+    std::function<void(const trial_fn &)> before_solve;
+    // print the result of a solve that took elapsed microseconds (by default "Elapsed time: elapsed"), e.g. with the
+    // stats of the backend
+    std::function<void(time_t elapsed)> report;
+};
+
+// Create A, b and x as selected by the options (A and b read from the file or generated from the seed by gen_nw
+// threads), solve the system (or the batch of right-hand sides) with solver and print the result. The rows of a dense
+// A are first touched by the workers of the solver, pinned on thread_cpus (if it is not empty)
+void run_front_end(front_end &fe, JacobiSolver &solver, int gen_nw, const std::vector<int> &thread_cpus,
+                   const front_end_hooks &hooks = {});
+
+#endif
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "system_file.h"
+#include "utils.h"
+
+#define MAX_VALUE 32
+#define MIN_VALUE -32
+
+
+// Write the random linear system generated by initialize_problem to a file, which can then be solved by the other
+// programs with the option --system=file
+int main(int argc, char *argv[]) {
+
+    int seed = std::stoul(argv[1]); //seed to generate random numbers
+    int n = std::stoul(argv[2]); //linear system's dimension
+    std::string path = argv[3]; //file to write
+    std::string format = get_option(argc, argv, "format", "dense"); //format of A in the file (dense, csr)
+    int row_nnz = std::stoul(get_option(argc, argv, "row_nnz", "0")); //if not 0, A is sparse with this number of elements besides the diagonal in every row (always written in csr)
+    int gen_nw = std::max(1u, std::thread::hardware_concurrency()); //threads used to generate the linear system
+
+    // The sparse system is the same one generated by the solvers with --matrix=csr and the same seed and row_nnz
+    if (row_nnz > 0) {
+        SparseMatrix a(n, row_nnz);
+        std::vector<float> b(n);
+        initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, seed, gen_nw);
+        write_system(path, a, b);
+        std::cout << "Sparse system of dimension " << n << " written to " << path << std::endl;
+        return 0;
+    }
+
+    // Creation and initialization of A and b, the system is the same one generated by the solvers with the same seed
+    Matrix a(n, n);
+    std::vector<float> b(n);
+    initialize_problem(n, std::ref(a), std::ref(b), MIN_VALUE, MAX_VALUE, seed, gen_nw);
+
+    if (format == "dense")
+        write_system(path, a, b);
+    else if (format == "csr") {
+        // only the nonzero elements are written
+        std::vector<std::uint64_t> row_ptr(n + 1, 0);
+        std::vector<std::uint32_t> col_idx;
+        std::vector<float> values;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (a[i][j] != 0) {
+                    col_idx.push_back(j);
+                    values.push_back(a[i][j]);
+                }
+            }
+            row_ptr[i + 1] = values.size();
+        }
+        write_system_csr(path, n, row_ptr, col_idx, values, b);
+    }
+    else {
+        std::cerr << "unknown format " << format << std::endl;
+        return 1;
+    }
+
+    std::cout << "System of dimension " << n << " written to " << path << std::endl;
+
+    return 0;
+}
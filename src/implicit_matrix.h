@@ -0,0 +1,57 @@
+#ifndef IMPLICIT_MATRIX_H
+#define IMPLICIT_MATRIX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "utils.h"
+
+
+// Matrix A of the random linear system that is never stored: the elements are regenerated on the fly from
+// (seed, i, j) with the counter-based generator of initialize_problem, only the diagonal (modified to make the rows
+// strictly diagonally dominant) is kept in memory. A sweep costs n^2 generated numbers instead of 4*n^2 bytes read
+// from the memory, so n is limited only by the O(n) vectors. The elements are the same ones of the Matrix filled by
+// initialize_problem with the same seed
+class ImplicitMatrix {
+private:
+    int n;
+    std::uint64_t gen_key;
+    float min_v;
+    float max_v;
+    std::vector<float> diag;
+
+public:
+    explicit ImplicitMatrix(int n) : n(n), gen_key(0), min_v(0), max_v(0), diag(n) {}
+
+    int rows() const { return n; }
+    int cols() const { return n; }
+
+    // Set the generator of the elements, called by initialize_problem
+    void set_generator(std::uint64_t seed, float min_value, float max_value) {
+        gen_key = mix64(seed);
+        min_v = min_value;
+        max_v = max_value;
+    }
+
+    // key of counter_bits, and range of the elements
+    std::uint64_t key() const { return gen_key; }
+    float min_value() const { return min_v; }
+    float max_value() const { return max_v; }
+
+    // counter of the element a[i][j]
+    std::uint64_t counter(int i, int j) const { return (std::uint64_t) i * (n + 1) + j; }
+
+    float diagonal(int i) const { return diag[i]; }
+    void set_diagonal(int i, float value) { diag[i] = value; }
+
+    // Generate the elements j ... j + len - 1 of the i-th row in out (the diagonal element included)
+    void generate(int i, int j, int len, float *out) const {
+        std::uint64_t first = counter(i, j);
+        for (int c = 0; c < len; c++)
+            out[c] = min_v + static_cast<float>(counter_bits(gen_key, first + c)) * 0x1p-24f * (max_v - min_v);
+        if (i >= j && i < j + len)
+            out[i - j] = diag[i];
+    }
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "partition.h"
+#include "backend.h"
+#include "backends.h"
+#include "tuner.h"
+#include "solver.h"
+#include "front_end.h"
+#include "topology.h"
+#include "utils.h"
+
+int main(int argc, char *argv[]){
+
+    front_end fe(argc, argv);
+    int nw = std::stoul(argv[6]); //parallel degree
+    std::string backend = get_option(argc, argv, "backend", "barrier"); //backend executing the iterations (seq, barrier, tasks, omp, pstl, ff if built with FastFlow, auto to use the tuning cache or a calibration)
+
+    // Parameters of the backends, each backend uses only its own ones
+    backend_config cfg;
+    cfg.nw = nw;
+    cfg.barrier_kind = get_option(argc, argv, "barrier", "spin"); //barrier of the barrier backend (std, spin, tree)
+    cfg.spin = std::stoi(get_option(argc, argv, "spin", "-1")); //spin iterations before a thread parks on the barrier, -1 for the default of the parallel degree (also the tuned one)
+    cfg.part = parse_partition(get_option(argc, argv, "partition", "block")); //static partitioning of the rows of the barrier backend (block, block_cyclic, cyclic)
+    cfg.bsize = std::stoi(get_option(argc, argv, "bsize", std::to_string(DEFAULT_BSIZE))); //block size of the block_cyclic partitioning
+    cfg.chunk = std::stoi(get_option(argc, argv, "chunk", "0")); //rows of a chunk (tasks, omp, pstl, ff), 0 for the default of the backend
+    cfg.schedule = get_option(argc, argv, "schedule", "static"); //schedule of the omp backend (static, dynamic, guided) or of the chunks of the tasks backend (static, guided, adaptive)
+    cfg.spin_wait = std::stoi(get_option(argc, argv, "spin_wait", "0")) != 0; //if it's 1 the workers of the ff backend spin between the iterations
+    std::string affinity = get_option(argc, argv, "affinity", "none"); //cpus of the threads (none, compact, scatter, list of cpus)
+    cfg.thread_cpus = affinity_cpus(affinity, nw);
+    std::string tune_cache = get_option(argc, argv, "tune_cache", DEFAULT_TUNE_CACHE); //file of the configurations chosen with --backend=auto
+
+    // With --backend=auto the configuration is read from the tuning cache. If the cache has no configuration for this
+    // machine and this kind and size of system, the candidates are calibrated on the system before the solve and the
+    // fastest one is saved (until then the barrier backend only places the rows of A)
+    std::string key;
+    bool calibrate_first = false;
+    if (backend == "auto") {
+        key = tune_key(fe.system_kind(), fe.n);
+        if (std::optional<tuned_config> conf = load_tuned(tune_cache, key)) {
+            std::cout << "Tuned configuration: " << describe(*conf) << std::endl;
+            backend = conf->backend;
+            apply_tuned(*conf, cfg);
+            cfg.thread_cpus = affinity_cpus(affinity, cfg.nw);
+        }
+        else {
+            backend = "barrier";
+            calibrate_first = true;
+        }
+    }
+
+    // The workers are created once by the backend selected at runtime and reused by every solve
+    JacobiSolver solver(make_backend(backend, cfg));
+
+    // Calibrate the candidate configurations (at most nw threads) on the system, save the fastest one in the cache and
+    // use it
+    front_end_hooks hooks;
+    hooks.before_solve = [&](const trial_fn &trial) {
+        if (!calibrate_first)
+            return;
+        std::vector<tuned_config> candidates = tune_candidates(fe.n, cfg, affinity);
+        tuned_config best = calibrate(candidates, [&](JacobiSolver &candidate) {
+            trial(candidate, {TUNE_ITER, 1, 0.0f});
+        });
+        save_tuned(tune_cache, key, best);
+        std::cout << "Tuned configuration: " << describe(best) << std::endl;
+        apply_tuned(best, cfg);
+        cfg.thread_cpus = affinity_cpus(affinity, cfg.nw);
+        solver.set_backend(make_backend(best.backend, cfg));
+        calibrate_first = false;
+    };
+
+    // A and b are read from the file or generated from the seed by the nw threads, the rows of a dense A are first
+    // touched by the workers of the backend selected before the calibration
+    std::vector<int> first_cpus = cfg.thread_cpus;
+    run_front_end(fe, solver, nw, first_cpus, hooks);
+
+    return 0;
+}
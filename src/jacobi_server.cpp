@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "solver_service.h"
+#include "topology.h"
+#include "utils.h"
+#include "my_timer.cpp"
+
+#define MAX_VALUE 32
+#define MIN_VALUE -32
+
+
+// Throughput of the solver service: a stream of independent random systems of dimension between min_n and max_n is
+// submitted to a single pool of workers, the program prints the systems solved per second
+int main(int argc, char *argv[]) {
+
+    int seed = std::stoul(argv[1]); //seed to generate random numbers
+    int n_jobs = std::stoul(argv[2]); //number of systems to solve
+    int min_n = std::stoul(argv[3]); //minimum dimension of a system
+    int max_n = std::stoul(argv[4]); //maximum dimension of a system
+    int n_iter = std::stoul(argv[5]); //maximum number of iterations of every system
+    int ch_conv = std::stoul(argv[6]); //if it's 1 every system stops when it has converged, if it's 0 it will not
+    float tol = std::atof(argv[7]); //maximum tolerance for convergence, the program will use this value only if ch_conv == 1
+    int nw = std::stoul(argv[8]); //workers of the service
+    team_policy policy = parse_team_policy(get_option(argc, argv, "policy", "auto")); //workers of a job (auto, serial, parallel)
+    int team_rows = std::stoul(get_option(argc, argv, "team_rows", std::to_string(DEFAULT_TEAM_ROWS))); //minimum rows of every part of a system split among several workers
+    int distinct = std::stoul(get_option(argc, argv, "distinct", "32")); //different matrices generated, the jobs cycle over them
+    std::vector<int> thread_cpus = affinity_cpus(get_option(argc, argv, "affinity", "none"), nw); //cpus of the workers (none, compact, scatter, list of cpus)
+    int gen_nw = std::max(1u, std::thread::hardware_concurrency()); //threads used to generate the systems (not to solve them)
+
+    // The dimensions are log-uniform between min_n and max_n, the systems are generated before the measure and every
+    // job submits one of them with its own b
+    std::vector<std::shared_ptr<Matrix>> matrices;
+    std::vector<std::vector<float>> rhs;
+    for (int s = 0; s < std::min(distinct, n_jobs); s++) {
+        float u = counter_random(seed, s, 0.0f, 1.0f);
+        int n = std::max(1, (int) std::lround(min_n * std::pow((double) max_n / min_n, u)));
+        matrices.push_back(std::make_shared<Matrix>(n, n));
+        rhs.emplace_back(n);
+        initialize_problem(n, std::ref(*matrices.back()), std::ref(rhs.back()), MIN_VALUE, MAX_VALUE, seed + s, gen_nw);
+    }
+
+    SolverService service(nw, policy, team_rows, thread_cpus);
+
+    // Start to measure the elapsed time
+    my_timer timer;
+    timer.start_timer();
+
+    std::vector<std::future<JobResult>> results;
+    for (int j = 0; j < n_jobs; j++) {
+        int s = j % matrices.size();
+        results.push_back(service.submit({matrices[s], rhs[s], n_iter, ch_conv, tol}));
+    }
+
+    long iterations = 0, threads = 0;
+    for (std::future<JobResult> &r : results) {
+        JobResult res = r.get();
+        iterations += res.iterations;
+        threads += res.threads;
+    }
+
+    // Measure the elapsed time and print the result.
+    time_t elapsed = timer.get_time();
+    std::cout << "Elapsed time: " << elapsed << std::endl;
+    std::cout << "Systems per second: " << n_jobs / (elapsed / 1e6) << std::endl;
+    std::cout << "Average iterations: " << (double) iterations / n_jobs << ", average workers per system: "
+              << (double) threads / n_jobs << std::endl;
+
+    return 0;
+}
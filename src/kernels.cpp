@@ -0,0 +1,806 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86_KERNELS
+#endif
+
+#include "kernels.h"
+
+
+// Portable version, four independent accumulators break the dependency chain of the serial reduction
+static float dot_scalar(const float *a, const float *x, int n) {
+
+    float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        s0 += a[j]*x[j];
+        s1 += a[j+1]*x[j+1];
+        s2 += a[j+2]*x[j+2];
+        s3 += a[j+3]*x[j+3];
+    }
+    for (; j < n; j++)
+        s0 += a[j]*x[j];
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void rows_dot_scalar(const float *a, std::size_t stride, const float *x, int n, float *acc) {
+
+    const float *a0 = a, *a1 = a + stride, *a2 = a + 2*stride, *a3 = a + 3*stride;
+    float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (int j = 0; j < n; j++) {
+        float xj = x[j];
+        s0 += a0[j]*xj;
+        s1 += a1[j]*xj;
+        s2 += a2[j]*xj;
+        s3 += a3[j]*xj;
+    }
+
+    acc[0] += s0;
+    acc[1] += s1;
+    acc[2] += s2;
+    acc[3] += s3;
+}
+
+#ifdef X86_KERNELS
+
+__attribute__((target("sse2")))
+static float hsum_sse(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("avx2,fma")))
+static float hsum_avx2(__m256 v) {
+    return hsum_sse(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("sse2")))
+static float dot_sse(const float *a, const float *x, int n) {
+
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(x + j)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + j + 4), _mm_loadu_ps(x + j + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + j + 8), _mm_loadu_ps(x + j + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + j + 12), _mm_loadu_ps(x + j + 12)));
+    }
+    for (; j + 4 <= n; j += 4)
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(x + j)));
+
+    float sum = hsum_sse(_mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+
+    for (; j < n; j++)
+        sum += a[j]*x[j];
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float *a, const float *x, int n) {
+
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 32 <= n; j += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(x + j), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 8), _mm256_loadu_ps(x + j + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 16), _mm256_loadu_ps(x + j + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 24), _mm256_loadu_ps(x + j + 24), acc3);
+    }
+    for (; j + 8 <= n; j += 8)
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(x + j), acc0);
+
+    float sum = hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+
+    for (; j < n; j++)
+        sum += a[j]*x[j];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(const float *a, const float *x, int n) {
+
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+    int j = 0;
+    for (; j + 64 <= n; j += 64) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(x + j), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j + 16), _mm512_loadu_ps(x + j + 16), acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j + 32), _mm512_loadu_ps(x + j + 32), acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j + 48), _mm512_loadu_ps(x + j + 48), acc3);
+    }
+    for (; j + 16 <= n; j += 16)
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(x + j), acc0);
+
+    // the last elements are loaded with a mask, so no scalar loop is needed
+    if (j < n) {
+        __mmask16 mask = (__mmask16) ((1u << (n - j)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + j), _mm512_maskz_loadu_ps(mask, x + j), acc1);
+    }
+
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+__attribute__((target("sse2")))
+static void rows_dot_sse(const float *a, std::size_t stride, const float *x, int n, float *acc) {
+
+    const float *a0 = a, *a1 = a + stride, *a2 = a + 2*stride, *a3 = a + 3*stride;
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128 xv = _mm_loadu_ps(x + j);
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a0 + j), xv));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a1 + j), xv));
+        s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(a2 + j), xv));
+        s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(a3 + j), xv));
+    }
+
+    float r0 = hsum_sse(s0), r1 = hsum_sse(s1), r2 = hsum_sse(s2), r3 = hsum_sse(s3);
+    for (; j < n; j++) {
+        r0 += a0[j]*x[j];
+        r1 += a1[j]*x[j];
+        r2 += a2[j]*x[j];
+        r3 += a3[j]*x[j];
+    }
+
+    acc[0] += r0;
+    acc[1] += r1;
+    acc[2] += r2;
+    acc[3] += r3;
+}
+
+// Two accumulators per row, so that eight FMAs are independent and the latency of the FMA unit is hidden
+__attribute__((target("avx2,fma")))
+static void rows_dot_avx2(const float *a, std::size_t stride, const float *x, int n, float *acc) {
+
+    const float *a0 = a, *a1 = a + stride, *a2 = a + 2*stride, *a3 = a + 3*stride;
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    __m256 t0 = _mm256_setzero_ps(), t1 = _mm256_setzero_ps(), t2 = _mm256_setzero_ps(), t3 = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m256 xv = _mm256_loadu_ps(x + j);
+        __m256 xw = _mm256_loadu_ps(x + j + 8);
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), xv, s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), xv, s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), xv, s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), xv, s3);
+        t0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j + 8), xw, t0);
+        t1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j + 8), xw, t1);
+        t2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j + 8), xw, t2);
+        t3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j + 8), xw, t3);
+    }
+    for (; j + 8 <= n; j += 8) {
+        __m256 xv = _mm256_loadu_ps(x + j);
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), xv, s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), xv, s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), xv, s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), xv, s3);
+    }
+
+    float r0 = hsum_avx2(_mm256_add_ps(s0, t0)), r1 = hsum_avx2(_mm256_add_ps(s1, t1));
+    float r2 = hsum_avx2(_mm256_add_ps(s2, t2)), r3 = hsum_avx2(_mm256_add_ps(s3, t3));
+    for (; j < n; j++) {
+        r0 += a0[j]*x[j];
+        r1 += a1[j]*x[j];
+        r2 += a2[j]*x[j];
+        r3 += a3[j]*x[j];
+    }
+
+    acc[0] += r0;
+    acc[1] += r1;
+    acc[2] += r2;
+    acc[3] += r3;
+}
+
+__attribute__((target("avx512f")))
+static void rows_dot_avx512(const float *a, std::size_t stride, const float *x, int n, float *acc) {
+
+    const float *a0 = a, *a1 = a + stride, *a2 = a + 2*stride, *a3 = a + 3*stride;
+    __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps(), s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+    __m512 t0 = _mm512_setzero_ps(), t1 = _mm512_setzero_ps(), t2 = _mm512_setzero_ps(), t3 = _mm512_setzero_ps();
+    int j = 0;
+    for (; j + 32 <= n; j += 32) {
+        __m512 xv = _mm512_loadu_ps(x + j);
+        __m512 xw = _mm512_loadu_ps(x + j + 16);
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + j), xv, s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + j), xv, s1);
+        s2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + j), xv, s2);
+        s3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + j), xv, s3);
+        t0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + j + 16), xw, t0);
+        t1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + j + 16), xw, t1);
+        t2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + j + 16), xw, t2);
+        t3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + j + 16), xw, t3);
+    }
+    for (; j < n; j += 16) {
+        // the last elements are loaded with a mask
+        __mmask16 mask = n - j >= 16 ? (__mmask16) 0xFFFF : (__mmask16) ((1u << (n - j)) - 1);
+        __m512 xv = _mm512_maskz_loadu_ps(mask, x + j);
+        s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a0 + j), xv, s0);
+        s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a1 + j), xv, s1);
+        s2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a2 + j), xv, s2);
+        s3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a3 + j), xv, s3);
+    }
+
+    acc[0] += _mm512_reduce_add_ps(_mm512_add_ps(s0, t0));
+    acc[1] += _mm512_reduce_add_ps(_mm512_add_ps(s1, t1));
+    acc[2] += _mm512_reduce_add_ps(_mm512_add_ps(s2, t2));
+    acc[3] += _mm512_reduce_add_ps(_mm512_add_ps(s3, t3));
+}
+
+#endif
+
+
+using dot_fn = float (*)(const float*, const float*, int);
+using rows_fn = void (*)(const float*, std::size_t, const float*, int, float*);
+
+struct dot_impl {
+    dot_fn fn;
+    rows_fn rows;
+    const char *isa;
+};
+
+// Select the implementation of row_dot, it is executed only once (at the initialization of the program)
+static dot_impl select_dot() {
+
+    const char *forced = std::getenv("JACOBI_ISA");
+
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    bool has_avx512 = __builtin_cpu_supports("avx512f");
+    bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    bool has_sse = __builtin_cpu_supports("sse2");
+
+    if (forced != nullptr) {
+        if (std::strcmp(forced, "avx512") == 0 && has_avx512)
+            return {dot_avx512, rows_dot_avx512, "avx512"};
+        if (std::strcmp(forced, "avx2") == 0 && has_avx2)
+            return {dot_avx2, rows_dot_avx2, "avx2"};
+        if (std::strcmp(forced, "sse") == 0 && has_sse)
+            return {dot_sse, rows_dot_sse, "sse"};
+        if (std::strcmp(forced, "scalar") == 0)
+            return {dot_scalar, rows_dot_scalar, "scalar"};
+    }
+
+    if (has_avx512)
+        return {dot_avx512, rows_dot_avx512, "avx512"};
+    if (has_avx2)
+        return {dot_avx2, rows_dot_avx2, "avx2"};
+    if (has_sse)
+        return {dot_sse, rows_dot_sse, "sse"};
+#endif
+
+    return {dot_scalar, rows_dot_scalar, "scalar"};
+}
+
+static const dot_impl selected_dot = select_dot();
+
+
+// Generation of the elements first ... first + len - 1 of the random matrix for the matrix-free kernel, the values are
+// the ones of ImplicitMatrix::generate
+using gen_fn = void (*)(std::uint64_t key, std::uint64_t first, int len, float min_value, float range, float *out);
+
+static void gen_scalar(std::uint64_t key, std::uint64_t first, int len, float min_value, float range, float *out) {
+    for (int c = 0; c < len; c++)
+        out[c] = min_value + static_cast<float>(counter_bits(key, first + c)) * 0x1p-24f * range;
+}
+
+#ifdef X86_KERNELS
+// The 64-bit multiplications of the mixer are vectorized only with AVX-512DQ, the bits (24) are converted to float as
+// signed 32-bit integers, which has a vector instruction (the value is the same)
+__attribute__((target("avx512f,avx512dq")))
+static void gen_avx512(std::uint64_t key, std::uint64_t first, int len, float min_value, float range, float *out) {
+    for (int c = 0; c < len; c++)
+        out[c] = min_value + static_cast<float>(static_cast<std::int32_t>(counter_bits(key, first + c))) * 0x1p-24f
+                 * range;
+}
+#endif
+
+static gen_fn select_gen() {
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (std::strcmp(selected_dot.isa, "avx512") == 0 && __builtin_cpu_supports("avx512dq"))
+        return gen_avx512;
+#endif
+    return gen_scalar;
+}
+
+static const gen_fn selected_gen = select_gen();
+
+
+// Products between a slice of a SELL-C-sigma matrix (width columns of SELL_C elements, column by column) and x,
+// acc[r] is the sum of the r-th row of the slice
+using slice_fn = void (*)(const float *val, const std::uint32_t *col, int width, const float *x, float *acc);
+
+static void slice_scalar(const float *val, const std::uint32_t *col, int width, const float *x, float *acc) {
+    for (int r = 0; r < SELL_C; r++)
+        acc[r] = 0.0;
+    for (int j = 0; j < width; j++, val += SELL_C, col += SELL_C)
+        for (int r = 0; r < SELL_C; r++)
+            acc[r] += val[r]*x[col[r]];
+}
+
+#ifdef X86_KERNELS
+// A column of the slice is two vectors of 8 elements, x is read with gathers
+__attribute__((target("avx2,fma")))
+static void slice_avx2(const float *val, const std::uint32_t *col, int width, const float *x, float *acc) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    for (int j = 0; j < width; j++, val += SELL_C, col += SELL_C) {
+        __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col));
+        __m256i c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + 8));
+        s0 = _mm256_fmadd_ps(_mm256_load_ps(val), _mm256_i32gather_ps(x, c0, 4), s0);
+        s1 = _mm256_fmadd_ps(_mm256_load_ps(val + 8), _mm256_i32gather_ps(x, c1, 4), s1);
+    }
+    _mm256_storeu_ps(acc, s0);
+    _mm256_storeu_ps(acc + 8, s1);
+}
+
+// A column of the slice is a vector of 16 elements
+__attribute__((target("avx512f")))
+static void slice_avx512(const float *val, const std::uint32_t *col, int width, const float *x, float *acc) {
+    __m512 s = _mm512_setzero_ps();
+    for (int j = 0; j < width; j++, val += SELL_C, col += SELL_C) {
+        __m512i c = _mm512_loadu_si512(col);
+        s = _mm512_fmadd_ps(_mm512_load_ps(val), _mm512_i32gather_ps(c, x, 4), s);
+    }
+    _mm512_storeu_ps(acc, s);
+}
+#endif
+
+// The slices use the instruction set of row_dot, SSE has no gather
+static slice_fn select_slice() {
+#ifdef X86_KERNELS
+    if (std::strcmp(selected_dot.isa, "avx512") == 0)
+        return slice_avx512;
+    if (std::strcmp(selected_dot.isa, "avx2") == 0)
+        return slice_avx2;
+#endif
+    return slice_scalar;
+}
+
+static const slice_fn selected_slice = select_slice();
+
+
+// Products between a block of rows of A and a tile of rows of X_old of a batch of right-hand sides: acc[r*ldacc + c]
+// += sum_j a[r*stride + j]*xo[j*ldx + c] for r < rows (at most ROW_BLOCK), j < len and c < k. The rows of xo and acc
+// are padded, so the columns are computed in whole vectors
+using multi_fn = void (*)(const float *a, std::size_t stride, int rows, const float *xo, std::size_t ldx, int len,
+                          int k, float *acc, std::size_t ldacc);
+
+static void multi_scalar(const float *a, std::size_t stride, int rows, const float *xo, std::size_t ldx, int len,
+                         int k, float *acc, std::size_t ldacc) {
+    for (int r = 0; r < rows; r++) {
+        float *ar = acc + r*ldacc;
+        for (int j = 0; j < len; j++) {
+            float arj = a[r*stride + j];
+            const float *xj = xo + j*ldx;
+            for (int c = 0; c < k; c++)
+                ar[c] += arj*xj[c];
+        }
+    }
+}
+
+#ifdef X86_KERNELS
+// R rows and G vectors of 16 columns: every element of A is broadcast once and multiplied by the G vectors of the
+// row of X_old, the R*G sums stay in the registers for the whole tile
+template <int R, int G>
+__attribute__((target("avx512f")))
+static inline void multi_block_avx512(const float *a, std::size_t stride, const float *xo, std::size_t ldx, int len,
+                                    float *acc, std::size_t ldacc) {
+    // with few columns U rows of X_old are computed at a time in independent sums, so that at least 16 FMAs are
+    // independent and the latency of the FMA unit is hidden
+    constexpr int U = std::max(1, std::min(4, 16 / (R*G)));
+    __m512 s[U][R][G];
+    for (int r = 0; r < R; r++)
+        for (int g = 0; g < G; g++) {
+            s[0][r][g] = _mm512_loadu_ps(acc + r*ldacc + 16*g);
+            for (int u = 1; u < U; u++)
+                s[u][r][g] = _mm512_setzero_ps();
+        }
+    int j = 0;
+    for (; j + U <= len; j += U)
+        for (int u = 0; u < U; u++) {
+            __m512 xv[G];
+            for (int g = 0; g < G; g++)
+                xv[g] = _mm512_loadu_ps(xo + (j + u)*ldx + 16*g);
+            for (int r = 0; r < R; r++) {
+                __m512 av = _mm512_set1_ps(a[r*stride + j + u]);
+                for (int g = 0; g < G; g++)
+                    s[u][r][g] = _mm512_fmadd_ps(av, xv[g], s[u][r][g]);
+            }
+        }
+    for (; j < len; j++)
+        for (int r = 0; r < R; r++) {
+            constexpr int u = 0;
+            __m512 av = _mm512_set1_ps(a[r*stride + j + u]);
+            for (int g = 0; g < G; g++)
+                s[0][r][g] = _mm512_fmadd_ps(av, _mm512_loadu_ps(xo + j*ldx + 16*g), s[0][r][g]);
+        }
+    for (int r = 0; r < R; r++)
+        for (int g = 0; g < G; g++) {
+            for (int u = 1; u < U; u++)
+                s[0][r][g] = _mm512_add_ps(s[0][r][g], s[u][r][g]);
+            _mm512_storeu_ps(acc + r*ldacc + 16*g, s[0][r][g]);
+        }
+}
+
+template <int R>
+__attribute__((target("avx512f")))
+static void multi_cols_avx512(const float *a, std::size_t stride, const float *xo, std::size_t ldx, int len, int g,
+                              float *acc, std::size_t ldacc) {
+    switch (g) {
+    case 1: multi_block_avx512<R, 1>(a, stride, xo, ldx, len, acc, ldacc); break;
+    case 2: multi_block_avx512<R, 2>(a, stride, xo, ldx, len, acc, ldacc); break;
+    case 3: multi_block_avx512<R, 3>(a, stride, xo, ldx, len, acc, ldacc); break;
+    default: multi_block_avx512<R, 4>(a, stride, xo, ldx, len, acc, ldacc); break;
+    }
+}
+
+// Up to 64 columns (4 vectors) at a time, 16 sums for a block of ROW_BLOCK rows
+__attribute__((target("avx512f")))
+static void multi_avx512(const float *a, std::size_t stride, int rows, const float *xo, std::size_t ldx, int len,
+                         int k, float *acc, std::size_t ldacc) {
+    for (int c = 0; c < k; c += 64) {
+        int g = std::min(4, (k - c + 15) / 16);
+        if (rows == ROW_BLOCK)
+            multi_cols_avx512<ROW_BLOCK>(a, stride, xo + c, ldx, len, g, acc + c, ldacc);
+        else
+            for (int r = 0; r < rows; r++)
+                multi_cols_avx512<1>(a + r*stride, stride, xo + c, ldx, len, g, acc + r*ldacc + c, ldacc);
+    }
+}
+
+// As multi_block_avx512 with vectors of 8 columns
+template <int R, int G>
+__attribute__((target("avx2,fma")))
+static inline void multi_block_avx2(const float *a, std::size_t stride, const float *xo, std::size_t ldx, int len,
+                                    float *acc, std::size_t ldacc) {
+    // at least 8 independent sums, the 16 registers would not hold more
+    constexpr int U = std::max(1, std::min(4, 8 / (R*G)));
+    __m256 s[U][R][G];
+    for (int r = 0; r < R; r++)
+        for (int g = 0; g < G; g++) {
+            s[0][r][g] = _mm256_loadu_ps(acc + r*ldacc + 8*g);
+            for (int u = 1; u < U; u++)
+                s[u][r][g] = _mm256_setzero_ps();
+        }
+    int j = 0;
+    for (; j + U <= len; j += U)
+        for (int u = 0; u < U; u++) {
+            __m256 xv[G];
+            for (int g = 0; g < G; g++)
+                xv[g] = _mm256_loadu_ps(xo + (j + u)*ldx + 8*g);
+            for (int r = 0; r < R; r++) {
+                __m256 av = _mm256_broadcast_ss(a + r*stride + j + u);
+                for (int g = 0; g < G; g++)
+                    s[u][r][g] = _mm256_fmadd_ps(av, xv[g], s[u][r][g]);
+            }
+        }
+    for (; j < len; j++)
+        for (int r = 0; r < R; r++) {
+            constexpr int u = 0;
+            __m256 av = _mm256_broadcast_ss(a + r*stride + j + u);
+            for (int g = 0; g < G; g++)
+                s[0][r][g] = _mm256_fmadd_ps(av, _mm256_loadu_ps(xo + j*ldx + 8*g), s[0][r][g]);
+        }
+    for (int r = 0; r < R; r++)
+        for (int g = 0; g < G; g++) {
+            for (int u = 1; u < U; u++)
+                s[0][r][g] = _mm256_add_ps(s[0][r][g], s[u][r][g]);
+            _mm256_storeu_ps(acc + r*ldacc + 8*g, s[0][r][g]);
+        }
+}
+
+// Up to 16 columns (2 vectors) at a time, the 16 registers hold 8 sums, the vectors of X_old and the broadcast
+__attribute__((target("avx2,fma")))
+static void multi_avx2(const float *a, std::size_t stride, int rows, const float *xo, std::size_t ldx, int len,
+                       int k, float *acc, std::size_t ldacc) {
+    for (int c = 0; c < k; c += 16) {
+        bool two = k - c > 8;
+        if (rows == ROW_BLOCK) {
+            if (two)
+                multi_block_avx2<ROW_BLOCK, 2>(a, stride, xo + c, ldx, len, acc + c, ldacc);
+            else
+                multi_block_avx2<ROW_BLOCK, 1>(a, stride, xo + c, ldx, len, acc + c, ldacc);
+        }
+        else
+            for (int r = 0; r < rows; r++) {
+                if (two)
+                    multi_block_avx2<1, 2>(a + r*stride, stride, xo + c, ldx, len, acc + r*ldacc + c, ldacc);
+                else
+                    multi_block_avx2<1, 1>(a + r*stride, stride, xo + c, ldx, len, acc + r*ldacc + c, ldacc);
+            }
+    }
+}
+#endif
+
+// The batches use the instruction set of row_dot, with SSE the portable version is vectorized by the compiler
+static multi_fn select_multi() {
+#ifdef X86_KERNELS
+    if (std::strcmp(selected_dot.isa, "avx512") == 0)
+        return multi_avx512;
+    if (std::strcmp(selected_dot.isa, "avx2") == 0)
+        return multi_avx2;
+#endif
+    return multi_scalar;
+}
+
+static const multi_fn selected_multi = select_multi();
+
+
+float row_dot(const float *a, const float *x, int n) {
+    return selected_dot.fn(a, x, n);
+}
+
+void rows_dot(const float *a, std::size_t stride, const float *x, int n, float *acc) {
+    selected_dot.rows(a, stride, x, n, acc);
+}
+
+const char *kernel_isa() {
+    return selected_dot.isa;
+}
+
+
+// Add the contributions of the unknowns first ... last - 1 to the partial sums of the stopping criterion
+static void add_norm(const float *x, const float *xo, int first, int last, norm_partial *norm) {
+
+    double num = 0.0, den = 0.0;
+    for (int i = first; i < last; i++) {
+        double diff = x[i] - xo[i];
+        num += diff*diff;
+        den += (double) x[i]*x[i];
+    }
+    norm->num += num;
+    norm->den += den;
+}
+
+// Compute the new values of the unknowns first ... last - 1 with the blocked kernel
+void jacobi_rows(Matrix &a, const float *b, const float *xo, float *x, int first, int last, norm_partial *norm) {
+
+    int n = a.cols();
+    std::size_t stride = a.stride();
+
+    // partial sums of the rows of the current panel
+    float acc[ROW_PANEL];
+
+    for (int p = first; p < last; p += ROW_PANEL) {
+        int p_end = std::min(p + ROW_PANEL, last);
+        for (int i = p; i < p_end; i++)
+            acc[i - p] = 0.0;
+
+        // the tile xo[c ... c + len - 1] is read from the L1 cache by every block of rows of the panel
+        for (int c = 0; c < n; c += COL_TILE) {
+            int len = std::min(COL_TILE, n - c);
+            int i = p;
+            for (; i + ROW_BLOCK <= p_end; i += ROW_BLOCK)
+                selected_dot.rows(a.row_ptr(i) + c, stride, xo + c, len, acc + (i - p));
+            for (; i < p_end; i++)
+                acc[i - p] += selected_dot.fn(a.row_ptr(i) + c, xo + c, len);
+        }
+
+        for (int i = p; i < p_end; i++) {
+            const float *ai = a.row_ptr(i);
+            float val = acc[i - p] - ai[i]*xo[i];
+            x[i] = (b[i] - val) / ai[i];
+        }
+
+        // the stopping criterion is accumulated while the new values are still in the L1 cache
+        if (norm != nullptr)
+            add_norm(x, xo, p, p_end, norm);
+    }
+}
+
+// Compute the new values of the unknowns first ... last - 1 of the active columns of a batch of right-hand sides
+void jacobi_rows(Matrix &a, RhsBatch &batch, int first, int last, norm_partial *norms) {
+
+    int n = a.cols();
+    int k = batch.active();
+    std::size_t stride = a.stride();
+    Matrix &b = batch.b(), &x = batch.x(), &xo = batch.xo();
+    std::size_t ld = xo.stride();
+
+    // the tiles of X_old are about 32KB, so a tile stays in the L1 (or L2) cache while a panel is computed
+    int tile = std::max(16, (int) (8192 / ld));
+
+    // partial sums of the rows of the current panel, ld for every row
+    thread_local aligned_vector acc;
+    if (acc.size() < ROW_PANEL * ld)
+        acc.resize(ROW_PANEL * ld);
+
+    for (int p = first; p < last; p += ROW_PANEL) {
+        int p_end = std::min(p + ROW_PANEL, last);
+        std::fill(acc.begin(), acc.begin() + (p_end - p) * ld, 0.0f);
+
+        for (int c = 0; c < n; c += tile) {
+            int len = std::min(tile, n - c);
+            for (int i = p; i < p_end; i += ROW_BLOCK)
+                selected_multi(a.row_ptr(i) + c, stride, std::min(ROW_BLOCK, p_end - i), xo.row_ptr(c), ld, len, k,
+                               acc.data() + (i - p) * ld, ld);
+        }
+
+        for (int i = p; i < p_end; i++) {
+            float aii = a.row_ptr(i)[i];
+            const float *acci = acc.data() + (i - p) * ld, *bi = b.row_ptr(i), *xoi = xo.row_ptr(i);
+            float *xi = x.row_ptr(i);
+            for (int c = 0; c < k; c++)
+                xi[c] = (bi[c] - (acci[c] - aii*xoi[c])) / aii;
+
+            if (norms != nullptr)
+                for (int c = 0; c < k; c++) {
+                    double diff = xi[c] - xoi[c];
+                    norms[c].num += diff*diff;
+                    norms[c].den += (double) xi[c]*xi[c];
+                }
+        }
+    }
+}
+
+// Compute the new values of the unknowns first ... last - 1 regenerating the rows of A
+void jacobi_rows(const ImplicitMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm) {
+
+    int n = a.cols();
+    float min_value = a.min_value(), range = a.max_value() - a.min_value();
+    alignas(64) float tile[COL_TILE];
+
+    for (int i = first; i < last; i++) {
+        float acc = 0.0;
+        for (int c = 0; c < n; c += COL_TILE) {
+            int len = std::min(COL_TILE, n - c);
+            selected_gen(a.key(), a.counter(i, c), len, min_value, range, tile);
+            // the diagonal element is excluded from the sum
+            if (i >= c && i < c + len)
+                tile[i - c] = 0.0;
+            acc += selected_dot.fn(tile, xo + c, len);
+        }
+        x[i] = (b[i] - acc) / a.diagonal(i);
+    }
+
+    if (norm != nullptr)
+        add_norm(x, xo, first, last, norm);
+}
+
+// Compute the new values of the unknowns first ... last - 1 of a sparse system
+void jacobi_rows(const SparseMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm) {
+
+    int n = a.rows();
+
+    // sell: the windows of SELL_SIGMA rows contained in first ... last - 1 (the rows lo ... hi - 1) are computed one
+    // slice at a time, the rows of the windows on the boundaries (and every row in csr) one at a time
+    int lo = last, hi = last;
+    if (a.format() == sparse_format::sell) {
+        lo = std::min((first + SELL_SIGMA - 1) / SELL_SIGMA * SELL_SIGMA, last);
+        hi = std::max(last == n ? n : last / SELL_SIGMA * SELL_SIGMA, lo);
+
+        const std::uint64_t *slice_ptr = a.slice_begin();
+        const int *perm = a.slice_rows();
+        alignas(64) float acc[SELL_C];
+        // (the last window may end in the middle of a slice: if it is not in the range, lo == hi is not a multiple of
+        // SELL_C and no slice must be computed)
+        for (int s = lo / SELL_C; lo < hi && s < (hi + SELL_C - 1) / SELL_C; s++) {
+            selected_slice(a.values() + slice_ptr[s], a.col_idx() + slice_ptr[s], a.slice_widths()[s], xo, acc);
+            for (int r = 0; r < SELL_C; r++) {
+                int i = perm[s * SELL_C + r];
+                if (i >= 0)
+                    x[i] = (b[i] - acc[r]) / a.diagonal(i);
+            }
+        }
+    }
+
+    for (int i = first; i < lo; i++)
+        x[i] = (b[i] - a.row_dot(i, xo)) / a.diagonal(i);
+    for (int i = hi; i < last; i++)
+        x[i] = (b[i] - a.row_dot(i, xo)) / a.diagonal(i);
+
+    if (norm != nullptr)
+        add_norm(x, xo, first, last, norm);
+}
+
+// One sweep of the stencil on the points first ... last - 1: the new value of the point i is (b[i] + sum of its
+// neighbours) / a[i][i], in[k] is the old value of the point in_first + k and out[k] the new value of out_first + k.
+// The terms are added one neighbour at a time for a grid line, so every loop is vectorized and the sum has always the
+// same order (the result does not depend on the tiles)
+static void stencil_sweep(const StencilMatrix &a, const float *b, const float *in, int in_first, float *out,
+                          int out_first, int first, int last) {
+
+    int nx = a.size_x(), ny = a.size_y(), nz = a.size_z();
+    int plane = nx * ny;
+    float diag = a.diagonal(0);
+    thread_local std::vector<float> zeros;
+    if ((int) zeros.size() < nx)
+        zeros.assign(nx, 0.0f);
+
+    for (int i = first; i < last; ) {
+        int line_end = std::min(last, (i / nx + 1) * nx);
+        int len = line_end - i;
+        int gx = i % nx, gy = (i / nx) % ny, gz = i / plane;
+        const float *c = in + (i - in_first);
+        float *o = out + (i - out_first);
+
+        // the neighbours outside the grid in y and z are read from a line of zeros and the first and the last point
+        // of the grid line (without the west or the east neighbour) are computed apart, so the other points are
+        // computed by a single pass with the neighbours always summed in the same order
+        const float *south = gy > 0 ? c - nx : zeros.data(), *north = gy < ny - 1 ? c + nx : zeros.data();
+        const float *down = gz > 0 ? c - plane : zeros.data(), *up = gz < nz - 1 ? c + plane : zeros.data();
+        auto point = [&](int k, float west, float east) {
+            float sum = b[i + k] + west + east + south[k] + north[k];
+            if (nz > 1)
+                sum += down[k] + up[k];
+            o[k] = sum / diag;
+        };
+        int k0 = gx == 0 ? 1 : 0;
+        int k1 = std::min(len, nx - 1 - gx);
+        if (k0 == 1)
+            point(0, 0.0f, nx > 1 ? c[1] : 0.0f);
+        if (nz > 1)
+            for (int k = k0; k < k1; k++)
+                o[k] = (b[i + k] + c[k - 1] + c[k + 1] + south[k] + north[k] + down[k] + up[k]) / diag;
+        else
+            for (int k = k0; k < k1; k++)
+                o[k] = (b[i + k] + c[k - 1] + c[k + 1] + south[k] + north[k]) / diag;
+        if (k1 < len && k1 >= k0)
+            point(k1, c[k1 - 1], 0.0f);
+
+        i = line_end;
+    }
+}
+
+// Compute the new values of the unknowns first ... last - 1 of a stencil, time_block sweeps at a time
+void jacobi_rows(const StencilMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm) {
+
+    int t_block = a.time_block();
+    if (t_block == 1) {
+        stencil_sweep(a, b, xo, 0, x, 0, first, last);
+        if (norm != nullptr)
+            add_norm(x, xo, first, last, norm);
+        return;
+    }
+
+    // The redundant points of a tile are about halo*(t_block - 1), at most a fourth of the useful ones
+    int n = a.rows();
+    int h = a.halo();
+    int tile = std::max(STENCIL_TILE, 4 * t_block * h);
+
+    // values of the intermediate sweeps, reused by the following calls of the thread
+    thread_local std::vector<float> buf[2];
+
+    for (int tf = first; tf < last; tf += tile) {
+        int tl = std::min(tf + tile, last);
+        int lo = std::max(0, tf - t_block * h);
+        int hi = std::min(n, tl + t_block * h);
+        for (std::vector<float> &v : buf)
+            if ((int) v.size() < hi - lo)
+                v.resize(hi - lo);
+
+        // the sweep s computes the tile extended by t_block - s halos, from the values of the sweep s - 1
+        const float *in = xo;
+        int in_first = 0;
+        for (int s = 1; s < t_block; s++) {
+            int r_lo = std::max(0, tf - (t_block - s) * h);
+            int r_hi = std::min(n, tl + (t_block - s) * h);
+            stencil_sweep(a, b, in, in_first, buf[s % 2].data(), lo, r_lo, r_hi);
+            in = buf[s % 2].data();
+            in_first = lo;
+        }
+        stencil_sweep(a, b, in, in_first, x, 0, tf, tl);
+
+        // the stopping criterion compares the last two sweeps
+        if (norm != nullptr) {
+            double num = 0.0, den = 0.0;
+            for (int i = tf; i < tl; i++) {
+                double diff = x[i] - in[i - in_first];
+                num += diff*diff;
+                den += (double) x[i]*x[i];
+            }
+            norm->num += num;
+            norm->den += den;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "matrix.h"
+#include "implicit_matrix.h"
+#include "sparse_matrix.h"
+#include "stencil.h"
+#include "rhs_batch.h"
+
+
+// Number of rows computed together by the blocked kernel (each element of x_old loaded from the cache is reused for
+// all of them). The chunks and the partitions of the parallel versions are multiples of this value
+constexpr int ROW_BLOCK = 4;
+
+// Number of rows sharing the same tile of x_old in jacobi_rows
+constexpr int ROW_PANEL = 32;
+
+// Length of the tiles of x_old (2048 floats = 8KB, so a tile stays in the L1 cache while a panel is computed)
+constexpr int COL_TILE = 2048;
+
+
+// Partial sums of the stopping criterion ||x - x_old||/||x|| computed by a thread (or a chunk) while it updates its rows.
+// Each instance fills a whole cache line, so the partial sums of different threads never share a line
+struct alignas(64) norm_partial {
+    double num = 0.0; // sum of (x[i] - x_old[i])^2
+    double den = 0.0; // sum of x[i]^2
+};
+
+// Reduce the partial sums of the threads into the stopping criterion ||x - x_old||/||x||
+inline float reduce_norm(const std::vector<norm_partial> &parts) {
+    double num = 0.0, den = 0.0;
+    for (const norm_partial &p : parts) {
+        num += p.num;
+        den += p.den;
+    }
+    return std::sqrt(num) / std::sqrt(den);
+}
+
+// Dot product between the vectors a and x of length n. The implementation (scalar, SSE, AVX2+FMA or AVX-512) is
+// chosen once at startup according to the instruction sets supported by the CPU, the environment variable JACOBI_ISA
+// (scalar, sse, avx2, avx512) can be used to force a specific implementation
+float row_dot(const float *a, const float *x, int n);
+
+// Add to acc[r] the dot product between the row a + r*stride and x (length n), for r = 0 ... ROW_BLOCK - 1. Each
+// vector of x is loaded once and used for ROW_BLOCK rows. Dispatched as row_dot
+void rows_dot(const float *a, std::size_t stride, const float *x, int n, float *acc);
+
+// Name of the instruction set used by row_dot and rows_dot
+const char *kernel_isa();
+
+// Compute the new value of the i-th unknown of the Jacobi method, i.e. (b[i] - sum_{j != i} a[i][j]*xo[j]) / a[i][i]
+inline float jacobi_row(Matrix &a, const float *b, const float *xo, int i) {
+    const float *ai = a.row_ptr(i);
+    float val = row_dot(ai, xo, a.cols()) - ai[i]*xo[i];
+    return (b[i] - val) / ai[i];
+}
+
+// Compute the new values of the unknowns first ... last - 1. The rows are processed in panels of ROW_PANEL rows, every
+// panel is swept one tile of COL_TILE columns at a time and every tile is used by blocks of ROW_BLOCK rows. If norm is
+// not null, the contributions of the rows to the stopping criterion are added to it
+void jacobi_rows(Matrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm = nullptr);
+
+// Matrix-free version of jacobi_rows: every row is regenerated one tile of COL_TILE columns at a time, the dot product
+// of each tile is computed by row_dot
+void jacobi_rows(const ImplicitMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm = nullptr);
+
+// Sparse version of jacobi_rows, the cost is proportional to the nonzero elements of the rows. In the sell format the
+// rows are computed one slice at a time (a SIMD gather of x for each column of the slice, with AVX2 or AVX-512) if the
+// range contains whole windows of SELL_SIGMA rows, the other rows are computed one at a time
+void jacobi_rows(const SparseMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm = nullptr);
+
+// Multi right-hand side version of jacobi_rows: computes the unknowns first ... last - 1 of the active columns of X
+// from X_old. The blocks of ROW_BLOCK rows sweep X_old one tile of rows at a time and every element of A is multiplied
+// by vectors of columns of X_old, so A is read once per iteration for the whole batch. If norms is not null, the
+// contributions to the stopping criterion of the column c are added to norms[c]
+void jacobi_rows(Matrix &a, RhsBatch &batch, int first, int last, norm_partial *norms = nullptr);
+
+// Stencil version of jacobi_rows: every call performs a.time_block() sweeps on the rows first ... last - 1 (the
+// intermediate sweeps of a tile in thread-local buffers, with redundant halos), x receives the values of the last one
+// and the stopping criterion is computed between the last two. With a single sweep the halos are read from xo
+void jacobi_rows(const StencilMatrix &a, const float *b, const float *xo, float *x, int first, int last,
+                 norm_partial *norm = nullptr);
+
+// Round a chunk size up to a multiple of ROW_BLOCK
+inline int round_to_block(int size) {
+    return size <= 0 ? ROW_BLOCK : (size + ROW_BLOCK - 1) / ROW_BLOCK * ROW_BLOCK;
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+// Dense row-major matrix stored in a single aligned buffer. Every row starts on a 64-byte boundary (the row stride is
+// padded to a multiple of 16 floats), so the rows are contiguous in memory and a[i][j] costs a single indirection.
+// The buffer is not initialized by the constructor: the pages are placed by whoever writes them first.
+class Matrix {
+private:
+    float *data;
+    int n_rows;
+    int n_cols;
+    std::size_t row_stride;
+    // index of the first row stored in the buffer (not 0 only for a view of a block of rows)
+    int row0;
+    // false if the buffer belongs to someone else (e.g. a memory-mapped file)
+    bool owner;
+
+public:
+    // alignment (in bytes) of the buffer and of every row
+    static constexpr std::size_t alignment = 64;
+
+    Matrix(int rows, int cols) : n_rows(rows), n_cols(cols), row0(0), owner(true) {
+
+        // Pad the rows to the alignment, a stride multiple of 4KB is padded once more to avoid cache set aliasing
+        // between consecutive rows
+        std::size_t floats_per_line = alignment / sizeof(float);
+        row_stride = (cols + floats_per_line - 1) / floats_per_line * floats_per_line;
+        if (row_stride != 0 && (row_stride * sizeof(float)) % 4096 == 0)
+            row_stride += floats_per_line;
+
+        data = static_cast<float*>(::operator new[](row_stride * rows * sizeof(float), std::align_val_t(alignment)));
+    }
+
+    // View of an external buffer with the same layout (stride multiple of 16 floats, rows aligned to 64 bytes), the
+    // buffer is not released by the matrix. If first_row is not 0 the buffer contains only the rows first_row ...
+    // first_row + rows - 1 of a larger matrix, which keep their indices
+    Matrix(float *buffer, int rows, int cols, std::size_t stride, int first_row = 0) : data(buffer), n_rows(rows),
+                                                                                       n_cols(cols), row_stride(stride),
+                                                                                       row0(first_row), owner(false) {}
+
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+
+    Matrix(Matrix &&other) noexcept : data(std::exchange(other.data, nullptr)), n_rows(other.n_rows),
+                                      n_cols(other.n_cols), row_stride(other.row_stride), row0(other.row0),
+                                      owner(other.owner) {}
+
+    ~Matrix() {
+        if (owner)
+            ::operator delete[](data, std::align_val_t(alignment));
+    }
+
+    // exchange the buffers (and the shapes) of two matrices, e.g. x and x_old of a batch of right-hand sides
+    void swap(Matrix &other) noexcept {
+        std::swap(data, other.data);
+        std::swap(n_rows, other.n_rows);
+        std::swap(n_cols, other.n_cols);
+        std::swap(row_stride, other.row_stride);
+        std::swap(row0, other.row0);
+        std::swap(owner, other.owner);
+    }
+
+    int rows() const { return n_rows; }
+    int cols() const { return n_cols; }
+
+    // distance (in floats) between the beginning of two consecutive rows
+    std::size_t stride() const { return row_stride; }
+
+    float *row_ptr(int i) { return data + static_cast<std::size_t>(i - row0) * row_stride; }
+    const float *row_ptr(int i) const { return data + static_cast<std::size_t>(i - row0) * row_stride; }
+
+    // view of the i-th row (the padding is not part of the view)
+    std::span<float> operator[](int i) { return {row_ptr(i), static_cast<std::size_t>(n_cols)}; }
+    std::span<const float> operator[](int i) const { return {row_ptr(i), static_cast<std::size_t>(n_cols)}; }
+};
+
+
+// Range of rows first ... last - 1 of a matrix
+struct row_range {
+    int first;
+    int last;
+};
+
+
+// Allocator aligning the buffer of a vector to Matrix::alignment bytes, so that a block of 16 floats starting at a
+// multiple of 16 fills exactly one cache line
+template <typename T>
+struct aligned_allocator {
+    using value_type = T;
+
+    aligned_allocator() = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U>&) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Matrix::alignment)));
+    }
+
+    void deallocate(T *p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Matrix::alignment));
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U>&) const { return true; }
+};
+
+// Vector of the unknowns of the linear system (x and x_old)
+using aligned_vector = std::vector<float, aligned_allocator<float>>;
+
+#endif
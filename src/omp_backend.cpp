@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include "omp_backend.h"
+#include "topology.h"
+
+
+// Return the omp_schedule called name
+omp_schedule parse_omp_schedule(const std::string &name) {
+
+    if (name == "static")
+        return omp_schedule::static_sched;
+    if (name == "dynamic")
+        return omp_schedule::dynamic_sched;
+    if (name == "guided")
+        return omp_schedule::guided_sched;
+
+    throw std::invalid_argument("unknown schedule " + name);
+}
+
+
+OmpBackend::OmpBackend(int nw, omp_schedule sched, int chunk, const std::vector<int> &thread_cpus) :
+        nw(nw), n(0), sched(sched), thread_cpus(thread_cpus) {
+    this->chunk = chunk <= 0 ? 0 : (chunk + LINE_ROWS - 1) / LINE_ROWS * LINE_ROWS;
+}
+
+// The static schedule gives every thread a contiguous range of blocks, or the chunks in a round-robin way
+std::vector<row_range> OmpBackend::worker_rows(int thr_n) const {
+
+    check_worker(thr_n);
+    if (chunk == 0)
+        return thread_rows(n, nw, thr_n, partition_kind::block);
+    return thread_rows(n, nw, thr_n, partition_kind::block_cyclic, chunk);
+}
+
+// Execute the iterations in a single parallel region
+int OmpBackend::run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    norms.assign((std::size_t) nw * width, norm_partial());
+
+    // The schedule(runtime) of the omp for takes the kind and the chunk (in blocks) from the caller
+    static const omp_sched_t kinds[] = {omp_sched_static, omp_sched_dynamic, omp_sched_guided};
+    omp_set_schedule(kinds[(int) sched], chunk / LINE_ROWS);
+
+    int blocks = (n + LINE_ROWS - 1) / LINE_ROWS;
+    int k = 0;
+    bool stop = n_iter <= 0;
+
+    // The thread 0 of the region is the caller, its cpus are restored at the end of the solve
+    std::vector<int> caller_cpus;
+    if (!thread_cpus.empty())
+        caller_cpus = thread_affinity();
+
+    #pragma omp parallel num_threads(nw)
+    {
+        int t = omp_get_thread_num();
+        if (!thread_cpus.empty())
+            pin_thread(thread_cpus[t]);
+        norm_partial *normp = width != 0 ? &norms[(std::size_t) t * width] : nullptr;
+
+        while (!stop) {
+            std::fill(norms.begin() + t * width, norms.begin() + (t + 1) * width, norm_partial());
+
+            // first ... last - 1 are the consecutive rows received by the thread and not computed yet
+            int first = 0, last = 0;
+            #pragma omp for schedule(runtime) nowait
+            for (int i = 0; i < blocks; i++) {
+                if (i * LINE_ROWS != last) {
+                    if (first < last)
+                        sweep(first, last, normp);
+                    first = i * LINE_ROWS;
+                }
+                last = std::min((i + 1) * LINE_ROWS, n);
+            }
+            if (first < last)
+                sweep(first, last, normp);
+
+            // every row has been computed before the end of the iteration, the other threads wait at the implicit
+            // barrier of the single
+            #pragma omp barrier
+            #pragma omp single
+            {
+                k++;
+                stop = end_iteration(norms, nw) || k >= n_iter;
+            }
+        }
+    }
+
+    if (!caller_cpus.empty())
+        set_thread_affinity(caller_cpus);
+    return k;
+}
@@ -0,0 +1,48 @@
+#ifndef OMP_BACKEND_H
+#define OMP_BACKEND_H
+
+#include <string>
+#include <vector>
+
+#include "backend.h"
+
+
+// Scheduling of the rows of the OpenMP backend (the schedule clause of its omp for)
+enum class omp_schedule { static_sched, dynamic_sched, guided_sched };
+
+// Return the omp_schedule called name (static, dynamic, guided), throws std::invalid_argument if it does not exist
+omp_schedule parse_omp_schedule(const std::string &name);
+
+
+// Backend built on OpenMP: a parallel region of nw threads executes all the iterations of a solve, the rows of every
+// iteration are split by an omp for with schedule(static | dynamic | guided, chunk) over blocks of LINE_ROWS rows (so
+// two threads never write the same cache line of x), and the serial end of the iteration is an omp single. The
+// consecutive blocks received by a thread are computed by a single call of the kernel. The threads of the region are
+// kept by the OpenMP runtime between the solves. Compiled with -fopenmp
+class OmpBackend : public Backend {
+private:
+    int nw;
+    int n;
+    omp_schedule sched;
+    // rows of a chunk of the omp for (a multiple of LINE_ROWS), 0 for the default chunk of the schedule
+    int chunk;
+    std::vector<int> thread_cpus;
+
+    // partial sums of the stopping criterion, width slots for each thread
+    std::vector<norm_partial> norms;
+
+public:
+    // nw threads, the i-th one pinned on thread_cpus[i] (if it is not empty), chunks of chunk rows (0 = default). The
+    // thread 0 is the caller of run, its previous cpus are restored at the end of the solve
+    OmpBackend(int nw, omp_schedule sched, int chunk, const std::vector<int> &thread_cpus);
+
+    int workers() const override { return nw; }
+    void prepare(int n) override { this->n = n; }
+
+    // The rows of the static schedule (the dynamic schedules may move them)
+    std::vector<row_range> worker_rows(int thr_n) const override;
+
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override;
+};
+
+#endif
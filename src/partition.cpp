@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "partition.h"
+#include "kernels.h"
+
+
+// Return the partition_kind called name
+partition_kind parse_partition(const std::string &name) {
+
+    if (name == "block")
+        return partition_kind::block;
+    if (name == "block_cyclic")
+        return partition_kind::block_cyclic;
+    if (name == "cyclic")
+        return partition_kind::cyclic;
+
+    throw std::invalid_argument("unknown partition " + name);
+}
+
+
+// Return the ranges of rows computed by the thread thr_n
+std::vector<row_range> thread_rows(int n, int nw, int thr_n, partition_kind kind, int bsize) {
+
+    std::vector<row_range> ranges;
+
+    if (kind == partition_kind::block) {
+        // the cache lines of x are divided as evenly as possible, the threads differ by at most one line
+        long lines = (n + LINE_ROWS - 1) / LINE_ROWS;
+        int first = lines * thr_n / nw * LINE_ROWS;
+        int last = std::min<long>(lines * (thr_n + 1) / nw * LINE_ROWS, n);
+        if (first < last)
+            ranges.push_back({first, last});
+        return ranges;
+    }
+
+    int block = ROW_BLOCK;
+    if (kind == partition_kind::block_cyclic)
+        block = bsize <= 0 ? LINE_ROWS : (bsize + LINE_ROWS - 1) / LINE_ROWS * LINE_ROWS;
+
+    for (long i = (long) thr_n * block; i < n; i += (long) nw * block)
+        ranges.push_back({(int) i, (int) std::min<long>(i + block, n)});
+
+    return ranges;
+}
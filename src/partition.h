@@ -0,0 +1,31 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+
+
+// Number of consecutive unknowns of x filling a cache line (x is allocated with aligned_allocator, so the line
+// boundaries of x fall on the multiples of this value)
+constexpr int LINE_ROWS = Matrix::alignment / sizeof(float);
+
+// Default block size of the block-cyclic partitioning
+constexpr int DEFAULT_BSIZE = 64;
+
+// Static partitioning of the rows among the threads of par_jacobi
+//  - block: every thread computes one contiguous range of rows, the boundaries are multiples of LINE_ROWS
+//  - block_cyclic: blocks of bsize rows (rounded up to a multiple of LINE_ROWS) assigned in a round-robin way
+//  - cyclic: blocks of ROW_BLOCK rows assigned in a round-robin way, consecutive threads write the same cache lines of x
+enum class partition_kind { block, block_cyclic, cyclic };
+
+// Return the partition_kind called name, throws std::invalid_argument if it does not exist
+partition_kind parse_partition(const std::string &name);
+
+// Return the ranges of rows (in increasing order) computed by the thread thr_n when the n rows are divided among nw
+// threads. Apart from the last row of the system, every range begins and ends on a cache line boundary of x, unless
+// kind is cyclic
+std::vector<row_range> thread_rows(int n, int nw, int thr_n, partition_kind kind, int bsize = DEFAULT_BSIZE);
+
+#endif
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+#include <tbb/global_control.h>
+
+#include "pstl_backend.h"
+
+
+// Limit of the threads of TBB used by the parallel algorithms
+struct PstlBackend::concurrency_limit {
+    tbb::global_control control;
+
+    explicit concurrency_limit(int nw) : control(tbb::global_control::max_allowed_parallelism, nw) {}
+};
+
+
+PstlBackend::PstlBackend(int nw, int chunk) : nw(nw), n(-1), limit(std::make_unique<concurrency_limit>(nw)) {
+    this->chunk = chunk <= 0 ? 0 : (chunk + LINE_ROWS - 1) / LINE_ROWS * LINE_ROWS;
+}
+
+PstlBackend::~PstlBackend() = default;
+
+// Split the rows into the parts of the for_each
+void PstlBackend::prepare(int n) {
+
+    if (n == this->n)
+        return;
+    this->n = n;
+
+    parts.clear();
+    if (chunk == 0)
+        for (int i = 0; i < nw; i++)
+            parts.push_back(thread_rows(n, nw, i, partition_kind::block)[0]);
+    else
+        for (int j = 0; j < n; j += chunk)
+            parts.push_back({j, std::min(j + chunk, n)});
+
+    index.resize(parts.size());
+    std::iota(index.begin(), index.end(), 0);
+}
+
+std::vector<row_range> PstlBackend::worker_rows(int thr_n) const {
+
+    check_worker(thr_n);
+    return thread_rows(n, nw, thr_n, partition_kind::block);
+}
+
+// Every iteration is a for_each over the parts followed by the end of the iteration
+int PstlBackend::run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    norms.assign(parts.size() * width, norm_partial());
+
+    for (int k = 1; k <= n_iter; k++) {
+        std::for_each(std::execution::par, index.begin(), index.end(), [&](int p) {
+            norm_partial *normp = width != 0 ? &norms[(std::size_t) p * width] : nullptr;
+            std::fill(normp, normp + width, norm_partial());
+            sweep(parts[p].first, parts[p].last, normp);
+        });
+        if (end_iteration(norms, parts.size()))
+            return k;
+    }
+    return n_iter;
+}
@@ -0,0 +1,46 @@
+#ifndef PSTL_BACKEND_H
+#define PSTL_BACKEND_H
+
+#include <memory>
+#include <vector>
+
+#include "backend.h"
+
+
+// Backend built on the parallel algorithms of the standard library: every iteration is a
+// std::for_each(std::execution::par) over the parts of the rows, nw parts of contiguous rows (chunk == 0) or chunks
+// of chunk rows (a multiple of LINE_ROWS), each with its own slots of the partial sums. The policy is par and not
+// par_unseq because some kernels (stencil, multiple right-hand sides) allocate their thread_local buffers in the sweep;
+// the kernels are vectorized anyway. With libstdc++ the algorithms run on the thread pool of TBB (link with -ltbb),
+// whose concurrency is limited to nw threads while the backend exists
+class PstlBackend : public Backend {
+private:
+    struct concurrency_limit;
+
+    int nw;
+    int n;
+    int chunk;
+    std::vector<row_range> parts;
+    // index of every part, the range of the for_each
+    std::vector<int> index;
+
+    // partial sums of the stopping criterion, width slots for each part
+    std::vector<norm_partial> norms;
+
+    std::unique_ptr<concurrency_limit> limit;
+
+public:
+    PstlBackend(int nw, int chunk);
+
+    ~PstlBackend();
+
+    int workers() const override { return nw; }
+    void prepare(int n) override;
+
+    // The parts are not bound to a thread, the rows of the worker thr_n are the thr_n-th contiguous range
+    std::vector<row_range> worker_rows(int thr_n) const override;
+
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "reorder.h"
+
+
+// Graph of A + A^T (without the diagonal) in CSR format
+struct sym_graph {
+    std::vector<int> ptr;
+    std::vector<int> adj;
+
+    int degree(int i) const { return ptr[i + 1] - ptr[i]; }
+};
+
+static sym_graph symmetric_graph(const SparseMatrix &a) {
+
+    int n = a.rows();
+    const std::uint64_t *row_ptr = a.row_ptr();
+    const std::uint32_t *col = a.col_idx();
+
+    // every element a[i][j] is an edge of i and of j, the duplicates (a[i][j] and a[j][i]) are removed afterwards
+    std::vector<int> count(n + 1, 0);
+    for (int i = 0; i < n; i++)
+        for (std::uint64_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            count[i + 1]++;
+            count[col[k] + 1]++;
+        }
+    std::partial_sum(count.begin(), count.end(), count.begin());
+
+    std::vector<int> adj(count[n]);
+    std::vector<int> fill(count.begin(), count.end() - 1);
+    for (int i = 0; i < n; i++)
+        for (std::uint64_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            adj[fill[i]++] = col[k];
+            adj[fill[col[k]]++] = i;
+        }
+
+    sym_graph g;
+    g.ptr.assign(n + 1, 0);
+    for (int i = 0; i < n; i++) {
+        auto first = adj.begin() + count[i], last = adj.begin() + count[i + 1];
+        std::sort(first, last);
+        last = std::unique(first, last);
+        g.adj.insert(g.adj.end(), first, last);
+        g.ptr[i + 1] = g.adj.size();
+    }
+    return g;
+}
+
+// Levels of a breadth-first visit: number of levels and index of the first node of the last one
+struct bfs_levels {
+    int depth;
+    std::size_t last;
+};
+
+// Breadth-first visit from root of the nodes with mark[v] != stamp, which are marked with stamp and appended to visit.
+// The neighbours of a node are visited in increasing order of degree
+static bfs_levels bfs(const sym_graph &g, int root, std::vector<int> &mark, int stamp, std::vector<int> &visit) {
+
+    mark[root] = stamp;
+    visit.push_back(root);
+
+    bfs_levels levels = {0, visit.size() - 1};
+    std::size_t level_begin = visit.size() - 1, level_end = visit.size();
+    while (level_begin < level_end) {
+        levels.depth++;
+        levels.last = level_begin;
+        for (std::size_t q = level_begin; q < level_end; q++) {
+            int v = visit[q];
+            std::size_t first = visit.size();
+            for (int k = g.ptr[v]; k < g.ptr[v + 1]; k++)
+                if (mark[g.adj[k]] != stamp) {
+                    mark[g.adj[k]] = stamp;
+                    visit.push_back(g.adj[k]);
+                }
+            std::stable_sort(visit.begin() + first, visit.end(), [&](int l, int r) {
+                return g.degree(l) < g.degree(r);
+            });
+        }
+        level_begin = level_end;
+        level_end = visit.size();
+    }
+    return levels;
+}
+
+// Reverse Cuthill-McKee order of the CSR matrix a
+Reordering::Reordering(const SparseMatrix &a) {
+
+    int n = a.rows();
+    sym_graph g = symmetric_graph(a);
+
+    // the components are started from their node of minimum degree
+    std::vector<int> by_degree(n);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](int l, int r) { return g.degree(l) < g.degree(r); });
+
+    // mark[v] is -1 once v is numbered, otherwise the stamp of the last visit that reached it
+    std::vector<int> mark(n, 0);
+    const int numbered = -1;
+    int stamp = 0;
+    std::vector<int> visit;
+    order.reserve(n);
+
+    for (int start : by_degree) {
+        if (mark[start] == numbered)
+            continue;
+
+        // Pseudo-peripheral node (George-Liu): move to the node of minimum degree of the last level as long as the
+        // number of levels grows
+        int root = start;
+        int depth = 0;
+        for (int it = 0; it < 8; it++) {
+            visit.clear();
+            bfs_levels levels = bfs(g, root, mark, ++stamp, visit);
+            if (levels.depth <= depth)
+                break;
+            depth = levels.depth;
+            int best = visit[levels.last];
+            for (std::size_t q = levels.last; q < visit.size(); q++)
+                if (g.degree(visit[q]) < g.degree(best))
+                    best = visit[q];
+            root = best;
+        }
+
+        // Cuthill-McKee numbering of the component
+        visit.clear();
+        bfs(g, root, mark, numbered, visit);
+        order.insert(order.end(), visit.begin(), visit.end());
+    }
+
+    std::reverse(order.begin(), order.end());
+}
+
+// Permute the rows and the columns of A, b and the initial x
+void Reordering::apply(SparseMatrix &a, std::vector<float> &b, aligned_vector &x) const {
+
+    if (order.empty())
+        return;
+
+    int n = a.rows();
+    std::vector<int> inverse(n);
+    for (int k = 0; k < n; k++)
+        inverse[order[k]] = k;
+
+    std::vector<std::uint64_t> ptr(n + 1, 0);
+    for (int k = 0; k < n; k++)
+        ptr[k + 1] = ptr[k] + a.row_nnz(order[k]);
+
+    SparseMatrix p(n, std::move(ptr));
+    std::vector<std::pair<std::uint32_t, float>> row;
+    for (int k = 0; k < n; k++) {
+        int i = order[k];
+        row.clear();
+        for (std::uint64_t e = a.row_ptr()[i]; e < a.row_ptr()[i + 1]; e++)
+            row.emplace_back(inverse[a.col_idx()[e]], a.values()[e]);
+        std::sort(row.begin(), row.end());
+
+        std::uint64_t e = p.row_ptr()[k];
+        for (const auto &[j, v] : row) {
+            p.col_idx()[e] = j;
+            p.values()[e++] = v;
+        }
+        p.set_diagonal(k, a.diagonal(i));
+    }
+    a = std::move(p);
+
+    std::vector<float> pb(n);
+    aligned_vector px(n);
+    for (int k = 0; k < n; k++) {
+        pb[k] = b[order[k]];
+        px[k] = x[order[k]];
+    }
+    b.swap(pb);
+    x.swap(px);
+}
+
+// Bring the solution back to the original order of the unknowns
+void Reordering::restore(aligned_vector &x) const {
+
+    if (order.empty())
+        return;
+
+    aligned_vector ox(x.size());
+    for (std::size_t k = 0; k < order.size(); k++)
+        ox[order[k]] = x[k];
+    x.swap(ox);
+}
+
+// Reordering named name
+Reordering make_reordering(const std::string &name, const SparseMatrix &a) {
+
+    if (name == "none")
+        return Reordering();
+    if (name == "rcm")
+        return Reordering(a);
+    throw std::invalid_argument("unknown reordering " + name);
+}
+
+// Bandwidth of A
+int bandwidth(const SparseMatrix &a) {
+
+    int band = 0;
+    for (int i = 0; i < a.rows(); i++)
+        for (std::uint64_t k = a.row_ptr()[i]; k < a.row_ptr()[i + 1]; k++)
+            band = std::max(band, std::abs((int) a.col_idx()[k] - i));
+    return band;
+}
@@ -0,0 +1,44 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "sparse_matrix.h"
+
+
+// Symmetric permutation of the unknowns of a sparse system, applied before the solve and undone on the solution. The
+// reverse Cuthill-McKee order numbers the unknowns by a breadth-first visit of the graph of A + A^T (the neighbours in
+// increasing order of degree, starting from a pseudo-peripheral node of every connected component) and reverses it:
+// the nonzero elements move close to the diagonal, so the rows of a chunk (or of a thread) read nearby elements of
+// x_old and the consecutive rows share their cache lines
+class Reordering {
+private:
+    // order[k] is the original index of the k-th unknown of the permuted system, empty for the identity
+    std::vector<int> order;
+
+public:
+    // Identity (no reordering)
+    Reordering() = default;
+
+    // Reverse Cuthill-McKee order of the CSR matrix a
+    explicit Reordering(const SparseMatrix &a);
+
+    bool empty() const { return order.empty(); }
+
+    // Permute the rows and the columns of A (which must be in CSR format), b and the initial x
+    void apply(SparseMatrix &a, std::vector<float> &b, aligned_vector &x) const;
+
+    // Bring the solution x of the permuted system back to the original order of the unknowns
+    void restore(aligned_vector &x) const;
+};
+
+// Reordering named name: none (identity) or rcm (reverse Cuthill-McKee of a). Throws std::invalid_argument for an
+// unknown name
+Reordering make_reordering(const std::string &name, const SparseMatrix &a);
+
+// Bandwidth of A, i.e. the maximum |i - j| of the nonzero elements a[i][j] (CSR format)
+int bandwidth(const SparseMatrix &a);
+
+#endif
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "rhs_batch.h"
+#include "kernels.h"
+
+
+// Batch of k right-hand sides, the padding of the rows is zeroed too so that the kernel can compute whole vectors of
+// columns
+RhsBatch::RhsBatch(int n, int k) : n(n), k(k), n_active(k), b_m(n, k), x_m(n, k), xo_m(n, k), sol(n, k), cols(k) {
+
+    for (Matrix *m : {&b_m, &x_m, &xo_m, &sol})
+        std::fill(m->row_ptr(0), m->row_ptr(0) + m->stride() * n, 0.0f);
+    std::iota(cols.begin(), cols.end(), 0);
+}
+
+// Save the column c of X_old as the solution of its original column
+void RhsBatch::save_column(int c) {
+    for (int i = 0; i < n; i++)
+        sol.row_ptr(i)[cols[c]] = xo_m.row_ptr(i)[c];
+}
+
+// Remove the converged columns and compact the active ones
+int RhsBatch::drop_converged(const std::vector<norm_partial> &parts, int nparts, float tol) {
+
+    std::vector<int> keep;
+    for (int c = 0; c < n_active; c++) {
+        double num = 0.0, den = 0.0;
+        for (int t = 0; t < nparts; t++) {
+            num += parts[(std::size_t) t * k + c].num;
+            den += parts[(std::size_t) t * k + c].den;
+        }
+        // a column that no longer changes (e.g. b = 0) has converged too
+        if (num == 0.0 || std::sqrt(num) / std::sqrt(den) < tol)
+            save_column(c);
+        else
+            keep.push_back(c);
+    }
+
+    int removed = n_active - (int) keep.size();
+    if (removed == 0)
+        return 0;
+
+    // The active columns are swapped to the front: keep is increasing, so the columns between the position of the
+    // next active column and its current one have all been removed. The removed columns stay in the batch (after the
+    // active ones), so B is never lost
+    for (int i = 0; i < n; i++) {
+        float *bi = b_m.row_ptr(i), *xoi = xo_m.row_ptr(i);
+        for (std::size_t c = 0; c < keep.size(); c++) {
+            std::swap(bi[c], bi[keep[c]]);
+            std::swap(xoi[c], xoi[keep[c]]);
+        }
+    }
+    for (std::size_t c = 0; c < keep.size(); c++)
+        std::swap(cols[c], cols[keep[c]]);
+    n_active = keep.size();
+
+    return removed;
+}
+
+// Save the solutions of the active columns
+void RhsBatch::finish() {
+    for (int c = 0; c < n_active; c++)
+        save_column(c);
+    n_active = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef RHS_BATCH_H
+#define RHS_BATCH_H
+
+#include <vector>
+
+#include "matrix.h"
+
+struct norm_partial;
+
+
+// Batch of k right-hand sides solved together (A X = B, option --rhs). B, X and X_old are n x k row-major matrices, so
+// the k values of an unknown are contiguous and every element of A loaded by the kernel is multiplied by a vector of
+// them. The first active() columns are the ones still iterated: when a column converges its solution is saved and the
+// remaining columns are swapped to the front, so the kernel always works on a contiguous block of columns
+class RhsBatch {
+private:
+    int n;
+    int k;
+    int n_active;
+    Matrix b_m;
+    Matrix x_m;
+    Matrix xo_m;
+    // solutions in the original order of the columns
+    Matrix sol;
+    // cols[c] is the original index of the column c, the active ones first
+    std::vector<int> cols;
+
+    // Save the column c of X_old as the solution of its original column
+    void save_column(int c);
+
+public:
+    // Batch of k right-hand sides of a system of dimension n, X_old is 0
+    RhsBatch(int n, int k);
+
+    int rows() const { return n; }
+    int size() const { return k; }
+    int active() const { return n_active; }
+
+    // original index of the column c of B, X and X_old (the active columns are the first active())
+    int column(int c) const { return cols[c]; }
+
+    // B, X and X_old, the columns are permuted as the columns are removed
+    Matrix &b() { return b_m; }
+    Matrix &x() { return x_m; }
+    Matrix &xo() { return xo_m; }
+
+    // X becomes the old solution of the next iteration, the buffers are swapped instead of copied
+    void swap() { x_m.swap(xo_m); }
+
+    // Remove from the batch the columns whose stopping criterion ||x - x_old||/||x|| is lower than tol, the partial
+    // sums of the column c are parts[t*size() + c] for t = 0 ... nparts - 1. Called after swap(), the solutions of the
+    // removed columns are the ones in X_old. Return the number of columns removed
+    int drop_converged(const std::vector<norm_partial> &parts, int nparts, float tol);
+
+    // Save the solutions of the columns still active (in X_old, after the last swap())
+    void finish();
+
+    // Solutions of the k systems, the column c is the solution of the c-th right-hand side
+    const Matrix &solution() const { return sol; }
+};
+
+#endif
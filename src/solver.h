@@ -0,0 +1,143 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "rhs_batch.h"
+#include "stream.h"
+#include "kernels.h"
+#include "backend.h"
+
+
+// Options of a solve
+struct solve_options {
+    // maximum number of iterations
+    int n_iter;
+    // if ch_conv != 0 the method stops when ||x - x_old||/||x|| < tol
+    int ch_conv = 0;
+    float tol = 0.0f;
+};
+
+// Result of a solve
+struct solve_result {
+    // iterations executed
+    int iterations;
+    // true if the stopping criterion has been satisfied
+    bool converged;
+};
+
+
+// Jacobi solver owning its workers (the backend) and its scratch buffers: the workers are created once by the backend
+// and x_old is reused by the solves of systems of the same size (or smaller), so repeated solves in one process pay
+// no thread creation and no allocation. The solves must be called by one thread at a time
+class JacobiSolver {
+private:
+    std::unique_ptr<Backend> exec;
+
+    // old solution of the iterations, x and xo are swapped at the end of every iteration instead of copied
+    aligned_vector xo;
+
+    // Split the rows of A among the workers, a sparse A may be balanced by its nonzero elements
+    template <typename MatrixT>
+    void prepare(const MatrixT &a) {
+        if constexpr (std::is_same_v<MatrixT, SparseMatrix>)
+            exec->prepare(a);
+        else
+            exec->prepare(a.rows());
+    }
+
+public:
+    explicit JacobiSolver(std::unique_ptr<Backend> backend) : exec(std::move(backend)) {}
+
+    Backend &backend() { return *exec; }
+
+    // Replace the backend (e.g. with the one chosen by a calibration), the scratch buffers are kept
+    void set_backend(std::unique_ptr<Backend> backend) { exec = std::move(backend); }
+
+    // Solve A x = b starting from the initial x, the solution is returned in x. MatrixT is any matrix with a
+    // jacobi_rows kernel (Matrix, ImplicitMatrix, SparseMatrix or StencilMatrix)
+    template <typename MatrixT>
+    solve_result solve(MatrixT &a, const std::vector<float> &b, aligned_vector &x, const solve_options &opts) {
+
+        prepare(a);
+        xo.assign(x.begin(), x.end());
+
+        bool converged = false;
+        sweep_fn sweep = [&](int first, int last, norm_partial *norm) {
+            jacobi_rows(a, b.data(), xo.data(), x.data(), first, last, norm);
+        };
+        end_fn end_iteration = [&](const std::vector<norm_partial> &partials, int) {
+            //check if the method has reached the convergence, in case stop the iterations
+            converged = opts.ch_conv != 0 && reduce_norm(partials) < opts.tol;
+            // x becomes the old solution of the next iteration, the buffers are swapped instead of copied
+            xo.swap(x);
+            return converged;
+        };
+        int k = exec->run(opts.n_iter, opts.ch_conv != 0 ? 1 : 0, sweep, end_iteration);
+
+        // the last solution computed is in xo
+        x.swap(xo);
+        return {k, converged};
+    }
+
+    // Solve A x = b with A read from the disk one block at a time, every iteration has a phase for each block (only
+    // with a backend supporting phases)
+    solve_result solve(BlockStream &a, const std::vector<float> &b, aligned_vector &x, const solve_options &opts) {
+
+        exec->prepare(a.rows());
+        xo.assign(x.begin(), x.end());
+
+        // the current block, the i-th block read has sequence number i
+        std::optional<Matrix> block;
+        long seq = 0;
+
+        bool converged = false;
+        block_fn begin_block = [&](int) { block.emplace(a.acquire(seq)); };
+        block_fn end_block = [&](int) { a.release(seq++); };
+        sweep_fn sweep = [&](int first, int last, norm_partial *norm) {
+            jacobi_rows(*block, b.data(), xo.data(), x.data(), first, last, norm);
+        };
+        end_fn end_iteration = [&](const std::vector<norm_partial> &partials, int) {
+            converged = opts.ch_conv != 0 && reduce_norm(partials) < opts.tol;
+            xo.swap(x);
+            return converged;
+        };
+        int k = exec->run_blocks(opts.n_iter, opts.ch_conv != 0 ? 1 : 0, a.block_rows(), begin_block, end_block,
+                                 sweep, end_iteration);
+
+        x.swap(xo);
+        return {k, converged};
+    }
+
+    // Solve A X = B for a batch of right-hand sides, the solutions are saved in the batch. The converged columns are
+    // removed from the batch at the end of every iteration, the method stops when every column has converged
+    solve_result solve(Matrix &a, RhsBatch &batch, const solve_options &opts) {
+
+        prepare(a);
+
+        bool converged = false;
+        sweep_fn sweep = [&](int first, int last, norm_partial *norms) {
+            jacobi_rows(a, batch, first, last, norms);
+        };
+        end_fn end_iteration = [&](const std::vector<norm_partial> &partials, int nparts) {
+            // X becomes the old solution of the next iteration, then the converged columns are removed
+            batch.swap();
+            converged = opts.ch_conv != 0 && batch.drop_converged(partials, nparts, opts.tol) > 0 &&
+                        batch.active() == 0;
+            return converged;
+        };
+        int k = exec->run(opts.n_iter, opts.ch_conv != 0 ? batch.size() : 0, sweep, end_iteration);
+
+        // the solutions of the columns still active are in X_old
+        batch.finish();
+        return {k, converged};
+    }
+};
+
+#endif
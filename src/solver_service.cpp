@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "solver_service.h"
+#include "barrier.h"
+#include "kernels.h"
+#include "topology.h"
+
+
+// Job waiting for a worker, with the promise of its solution
+struct SolverService::pending {
+    Job job;
+    std::promise<JobResult> result;
+};
+
+// Iteration of a job solved by a team, shared by the leader and the workers executing its chunks
+struct SolverService::team {
+    Job *job;
+    const float *xo;
+    float *x;
+    int parts;
+    bool check_conv;
+    // partial sums of the stopping criterion of every part
+    std::vector<norm_partial> norms;
+    // parts of the current iteration not completed yet
+    alignas(64) std::atomic<int> remaining;
+};
+
+
+// Start the workers
+SolverService::SolverService(int nw, team_policy policy, int team_rows, const std::vector<int> &thread_cpus) :
+        nw(nw), team_rows(std::max(1, team_rows)), policy(policy), spin(default_spin(nw)), queued_chunks(0),
+        stopping(false) {
+
+    for (int i = 0; i < nw; i++)
+        workers.emplace_back(&SolverService::worker_loop, this, i, thread_cpus);
+}
+
+// Complete the queued jobs and stop the workers
+SolverService::~SolverService() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    cond.notify_all();
+    for (std::thread &thr : workers)
+        thr.join();
+}
+
+// Queue a job
+std::future<JobResult> SolverService::submit(Job job) {
+
+    auto p = std::make_unique<pending>();
+    p->job = std::move(job);
+    std::future<JobResult> result = p->result.get_future();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobs.push_back(std::move(p));
+    }
+    cond.notify_one();
+    return result;
+}
+
+// Take a queued chunk
+bool SolverService::pop_chunk(chunk &c) {
+
+    if (queued_chunks.load(std::memory_order_relaxed) == 0)
+        return false;
+    std::lock_guard<std::mutex> guard(lock);
+    if (chunks.empty())
+        return false;
+    c = chunks.front();
+    chunks.pop_front();
+    queued_chunks.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Compute a part of an iteration of a team, the boundaries between the parts are multiples of 16 rows (a cache line
+// of x)
+void SolverService::run_chunk(const chunk &c) {
+
+    team &t = *c.t;
+    Matrix &a = *t.job->a;
+    int n = a.rows();
+    int first = (long) n * c.part / t.parts / 16 * 16;
+    int last = c.part == t.parts - 1 ? n : (long) n * (c.part + 1) / t.parts / 16 * 16;
+    jacobi_rows(a, t.job->b.data(), t.xo, t.x, first, last, t.check_conv ? &t.norms[c.part] : nullptr);
+
+    // the last access of the worker to the team, which may be released by the leader right after
+    t.remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// Solve a job alone or as the leader of a team
+void SolverService::solve(pending &p, int parts) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    Job &job = p.job;
+    int n = job.a->rows();
+    aligned_vector x(n, 0.0f), xo(n, 0.0f);
+
+    team t;
+    t.job = &job;
+    t.parts = parts;
+    t.check_conv = job.ch_conv != 0;
+    t.norms.resize(parts);
+
+    int k = 0;
+    bool stop = false;
+    while (k < job.n_iter && !stop) {
+        k++;
+        std::fill(t.norms.begin(), t.norms.end(), norm_partial());
+        t.xo = xo.data();
+        t.x = x.data();
+        t.remaining.store(parts, std::memory_order_relaxed);
+
+        if (parts > 1) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for (int part = 1; part < parts; part++)
+                    chunks.push_back({&t, part});
+                queued_chunks.fetch_add(parts - 1, std::memory_order_relaxed);
+            }
+            for (int part = 1; part < parts; part++)
+                cond.notify_one();
+        }
+        run_chunk({&t, 0});
+
+        // while the other parts are computed, the leader executes the chunks still queued (of its team or of
+        // another one)
+        chunk c;
+        for (int failed = 0; t.remaining.load(std::memory_order_acquire) > 0; ) {
+            if (pop_chunk(c))
+                run_chunk(c);
+            else if (++failed > spin)
+                std::this_thread::yield();
+            else
+                cpu_relax();
+        }
+
+        stop = t.check_conv && reduce_norm(t.norms) < job.tol;
+        // x becomes the old solution of the next iteration, the buffers are swapped instead of copied
+        xo.swap(x);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    p.result.set_value({std::move(xo), k, parts,
+                        (time_t) std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()});
+}
+
+// Main loop of a worker
+void SolverService::worker_loop(int thr_n, const std::vector<int> &thread_cpus) {
+
+    if (!thread_cpus.empty())
+        pin_thread(thread_cpus[thr_n]);
+
+    while (true) {
+        // a short spin catches the chunks of the next iteration of a team without sleeping on the condition variable
+        for (int i = 0; i < spin && queued_chunks.load(std::memory_order_relaxed) == 0; i++)
+            cpu_relax();
+
+        std::unique_lock<std::mutex> guard(lock);
+        cond.wait(guard, [&]() { return stopping || !chunks.empty() || !jobs.empty(); });
+
+        if (!chunks.empty()) {
+            chunk c = chunks.front();
+            chunks.pop_front();
+            queued_chunks.fetch_sub(1, std::memory_order_relaxed);
+            guard.unlock();
+            run_chunk(c);
+        }
+        else if (!jobs.empty()) {
+            std::unique_ptr<pending> p = std::move(jobs.front());
+            jobs.pop_front();
+
+            // a team only for a system large enough, and (automatic policy) if the other workers would otherwise
+            // stay idle
+            int parts = std::min(nw, p->job.a->rows() / team_rows);
+            if (policy == team_policy::serial || parts < 2 ||
+                (policy == team_policy::automatic && (int) jobs.size() >= nw - 1))
+                parts = 1;
+            guard.unlock();
+            solve(*p, parts);
+        }
+        else
+            return;
+    }
+}
+
+// Policy called name
+team_policy parse_team_policy(const std::string &name) {
+
+    if (name == "auto")
+        return team_policy::automatic;
+    if (name == "serial")
+        return team_policy::serial;
+    if (name == "parallel")
+        return team_policy::parallel;
+    throw std::invalid_argument("unknown team policy " + name);
+}
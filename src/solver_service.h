@@ -0,0 +1,118 @@
+#ifndef SOLVER_SERVICE_H
+#define SOLVER_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "utils.h"
+
+
+// Minimum number of rows of every part of a system split among several workers: a smaller system is solved by a
+// single worker, whose iteration is shorter than the cost of synchronizing a team
+constexpr int DEFAULT_TEAM_ROWS = 512;
+
+
+// A linear system submitted to the service, solved from x = 0. A is shared, so the same matrix can be submitted with
+// several right-hand sides without copies
+struct Job {
+    std::shared_ptr<Matrix> a;
+    std::vector<float> b;
+    int n_iter;
+    // if ch_conv != 0 the method stops when ||x - x_old||/||x|| < tol
+    int ch_conv;
+    float tol;
+};
+
+// Solution of a job
+struct JobResult {
+    aligned_vector x;
+    // iterations executed
+    int iterations;
+    // workers that solved the job
+    int threads;
+    // time (microseconds) between the start of the solve and its end
+    time_t elapsed;
+};
+
+// How the service chooses the workers of a job
+enum class team_policy {
+    automatic, // a team of workers only for a large system when some workers are idle
+    serial,    // every job on a single worker
+    parallel   // every large system on a team of workers
+};
+
+
+// Long-lived solver of a stream of independent dense systems on a fixed pool of workers, so that a job pays no thread
+// creation. The jobs are executed in the order of submission: every worker takes the next job and either solves it
+// alone, or becomes the leader of a team. In a team the rows of every iteration are split in parts, the leader pushes
+// the parts (except its own) in a queue of chunks that the workers serve before the jobs, and while it waits for them
+// it executes the parts still queued itself: a team never waits for a worker busy with another job, so the teams never
+// deadlock. A job is split in min(nw, n / team_rows) parts; with the automatic policy only when there are fewer queued
+// jobs than workers, otherwise solving the jobs side by side on single workers gives more systems per second
+class SolverService {
+private:
+    struct pending;
+    struct team;
+
+    // part of an iteration of a team
+    struct chunk {
+        team *t;
+        int part;
+    };
+
+    int nw;
+    int team_rows;
+    team_policy policy;
+    int spin;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<std::unique_ptr<pending>> jobs;
+    std::deque<chunk> chunks;
+    // size of chunks, read without the lock by the leaders waiting for their team and by the spinning workers
+    std::atomic<int> queued_chunks;
+    bool stopping;
+
+    std::vector<std::thread> workers;
+
+    // Main loop of a worker: executes the queued chunks first, then the jobs
+    void worker_loop(int thr_n, const std::vector<int> &thread_cpus);
+
+    // Solve a job on the calling worker alone or as the leader of a team of parts workers
+    void solve(pending &p, int parts);
+
+    // Compute a part of an iteration of a team
+    void run_chunk(const chunk &c);
+
+    // Take a queued chunk, if any
+    bool pop_chunk(chunk &c);
+
+public:
+    // Start nw workers, the i-th one pinned on thread_cpus[i] (if it is not empty)
+    SolverService(int nw, team_policy policy = team_policy::automatic, int team_rows = DEFAULT_TEAM_ROWS,
+                  const std::vector<int> &thread_cpus = {});
+
+    // The jobs still queued are completed before the workers stop
+    ~SolverService();
+
+    SolverService(const SolverService&) = delete;
+    SolverService& operator=(const SolverService&) = delete;
+
+    // Queue a job, the future receives its solution
+    std::future<JobResult> submit(Job job);
+
+    int num_workers() const { return nw; }
+};
+
+// Policy called name (auto, serial, parallel), throws std::invalid_argument for an unknown name
+team_policy parse_team_policy(const std::string &name);
+
+#endif
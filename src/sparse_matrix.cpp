@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "sparse_matrix.h"
+
+
+// CSR matrix with row_nnz elements in every row (at most n - 1)
+SparseMatrix::SparseMatrix(int n, int row_nnz) : n(n), fmt(sparse_format::csr), diag(n), ptr(n + 1) {
+
+    row_nnz = std::max(0, std::min(row_nnz, n - 1));
+    for (int i = 0; i <= n; i++)
+        ptr[i] = (std::uint64_t) i * row_nnz;
+    col.resize(ptr[n]);
+    val.resize(ptr[n]);
+}
+
+// CSR matrix with the row pointers row_ptr
+SparseMatrix::SparseMatrix(int n, std::vector<std::uint64_t> row_ptr) : n(n), fmt(sparse_format::csr), diag(n),
+                                                                         ptr(std::move(row_ptr)) {
+    col.resize(ptr[n]);
+    val.resize(ptr[n]);
+}
+
+// Convert a CSR matrix to the sell format
+void SparseMatrix::to_sell() {
+
+    if (fmt == sparse_format::sell)
+        return;
+
+    int n_slices = (n + SELL_C - 1) / SELL_C;
+
+    // Sort the rows of every window by decreasing length, the sort is stable so rows of the same length keep their
+    // order (and the accesses to x of consecutive rows stay close)
+    perm.assign(n_slices * SELL_C, -1);
+    std::iota(perm.begin(), perm.begin() + n, 0);
+    for (int w = 0; w < n; w += SELL_SIGMA)
+        std::stable_sort(perm.begin() + w, perm.begin() + std::min(w + SELL_SIGMA, n), [&](int l, int r) {
+            return row_nnz(l) > row_nnz(r);
+        });
+    pos.resize(n);
+    for (int p = 0; p < n; p++)
+        pos[perm[p]] = p;
+
+    // The width of a slice is the length of its first (longest) row
+    slice_width.resize(n_slices);
+    slice_ptr.resize(n_slices + 1);
+    slice_ptr[0] = 0;
+    for (int s = 0; s < n_slices; s++) {
+        slice_width[s] = row_nnz(perm[s * SELL_C]);
+        slice_ptr[s + 1] = slice_ptr[s] + (std::uint64_t) slice_width[s] * SELL_C;
+    }
+
+    // Copy the elements column by column, the padding elements multiply x[0] by 0
+    std::vector<std::uint32_t> sell_col(slice_ptr[n_slices], 0);
+    aligned_vector sell_val(slice_ptr[n_slices], 0.0f);
+    for (int p = 0; p < n; p++) {
+        int i = perm[p];
+        std::uint64_t k = slice_ptr[p / SELL_C] + p % SELL_C;
+        for (std::uint64_t e = ptr[i]; e < ptr[i + 1]; e++, k += SELL_C) {
+            sell_col[k] = col[e];
+            sell_val[k] = val[e];
+        }
+    }
+
+    col = std::move(sell_col);
+    val = std::move(sell_val);
+    fmt = sparse_format::sell;
+}
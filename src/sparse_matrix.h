@@ -0,0 +1,98 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "matrix.h"
+
+
+// Rows of a slice of the SELL-C-sigma format: a slice writes a whole cache line of x, and a column of a slice is a
+// vector of 16 floats (AVX-512)
+constexpr int SELL_C = 16;
+
+// Rows sorted by length in the SELL-C-sigma format (a multiple of SELL_C): the rows of a slice have similar lengths,
+// so the padding is small, and a row moves only inside its window of SELL_SIGMA rows
+constexpr int SELL_SIGMA = 128;
+
+// Storage format of a SparseMatrix
+enum class sparse_format { csr, sell };
+
+
+// Sparse matrix A of a linear system. The diagonal is stored in a separate vector, the other nonzero elements in one
+// of two formats:
+//  - csr: the elements of the row i are row_ptr()[i] ... row_ptr()[i + 1] - 1 of col_idx() and values()
+//  - sell (SELL-C-sigma): the rows are sorted by decreasing length inside windows of SELL_SIGMA rows, the position p
+//    of the sorted order belongs to the slice p / SELL_C. The elements of a slice are stored column by column (the
+//    j-th elements of its SELL_C rows are contiguous), every row of the slice is padded with zeros to the length of
+//    its longest row. A column of a slice is computed with a SIMD gather of x
+// The row pointers are kept in both formats (the number of nonzero elements of the rows is used to balance the work)
+class SparseMatrix {
+private:
+    int n;
+    sparse_format fmt;
+    std::vector<float> diag;
+    std::vector<std::uint64_t> ptr;
+    std::vector<std::uint32_t> col;
+    aligned_vector val;
+
+    // sell: first element and width (longest row) of every slice, row in every position (-1 for the padding rows of
+    // the last slice) and position of every row
+    std::vector<std::uint64_t> slice_ptr;
+    std::vector<int> slice_width;
+    std::vector<int> perm;
+    std::vector<int> pos;
+
+public:
+    // CSR matrix with row_nnz elements (besides the diagonal, at most n - 1) in every row, the elements are set by the
+    // caller
+    SparseMatrix(int n, int row_nnz);
+
+    // CSR matrix with the row pointers row_ptr (n + 1 elements), the elements are set by the caller
+    SparseMatrix(int n, std::vector<std::uint64_t> row_ptr);
+
+    int rows() const { return n; }
+    int cols() const { return n; }
+    sparse_format format() const { return fmt; }
+
+    // number of nonzero elements besides the diagonal, and of the row i
+    std::uint64_t nnz() const { return ptr[n]; }
+    int row_nnz(int i) const { return ptr[i + 1] - ptr[i]; }
+
+    // Rows whose range has to begin at a multiple of this value to be computed one slice at a time (sell)
+    int row_alignment() const { return fmt == sparse_format::sell ? SELL_SIGMA : 1; }
+
+    float diagonal(int i) const { return diag[i]; }
+    void set_diagonal(int i, float value) { diag[i] = value; }
+
+    // Arrays of the format, the elements of the CSR format are filled through them before the conversion to sell
+    const std::uint64_t *row_ptr() const { return ptr.data(); }
+    std::uint32_t *col_idx() { return col.data(); }
+    const std::uint32_t *col_idx() const { return col.data(); }
+    float *values() { return val.data(); }
+    const float *values() const { return val.data(); }
+
+    const std::uint64_t *slice_begin() const { return slice_ptr.data(); }
+    const int *slice_widths() const { return slice_width.data(); }
+    const int *slice_rows() const { return perm.data(); }
+
+    // Convert a CSR matrix to the sell format
+    void to_sell();
+
+    // Sum of a[i][j]*x[j] for j != i, in any format
+    float row_dot(int i, const float *x) const {
+        float sum = 0.0;
+        if (fmt == sparse_format::csr) {
+            for (std::uint64_t k = ptr[i]; k < ptr[i + 1]; k++)
+                sum += val[k]*x[col[k]];
+        }
+        else {
+            std::uint64_t k = slice_ptr[pos[i] / SELL_C] + pos[i] % SELL_C;
+            for (int j = row_nnz(i); j > 0; j--, k += SELL_C)
+                sum += val[k]*x[col[k]];
+        }
+        return sum;
+    }
+};
+
+#endif
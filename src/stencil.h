@@ -0,0 +1,79 @@
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+
+// Points of a tile of the temporal blocking: the values of a tile (and of its halo) in the intermediate sweeps stay in
+// the L2 cache (two buffers of 128KB)
+constexpr int STENCIL_TILE = 32768;
+
+
+// Matrix A of the Poisson problem on a 2D (5-point stencil) or 3D (7-point stencil) grid with side points per
+// dimension and zero Dirichlet boundary: a[i][i] = 2*dims and a[i][j] = -1 for the neighbours j of the point i. The
+// point (gx, gy, gz) is the unknown (gz*side + gy)*side + gx. Nothing is stored, the Jacobi kernel applies the stencil
+// directly.
+// With temporal blocking (time_block > 1) every call of the kernel performs time_block sweeps: the rows are split in
+// tiles and every tile is computed time_block times from x_old, extended by time_block - s halos (grid lines in 2D,
+// planes in 3D) at the sweep s, so that the tiles are independent (the halos are computed redundantly) and x_old and
+// b are read from the memory once every time_block sweeps
+class StencilMatrix {
+private:
+    int dims;
+    int side;
+    int n;
+    int t_block;
+
+public:
+    StencilMatrix(int dims, int side, int time_block = 1) : dims(dims), side(side), n(points(dims, side)),
+                                                             t_block(time_block < 1 ? 1 : time_block) {}
+
+    // Number of points of a grid, throws std::invalid_argument if it does not fit in an int
+    static int points(int dims, int side) {
+        long long p = (long long) side * side * (dims == 3 ? side : 1);
+        if (dims < 2 || dims > 3 || p > INT_MAX)
+            throw std::invalid_argument("invalid grid of side " + std::to_string(side));
+        return (int) p;
+    }
+
+    int rows() const { return n; }
+    int cols() const { return n; }
+    int dimensions() const { return dims; }
+
+    // points in the x, y and z dimensions (1 in z for a 2D grid)
+    int size_x() const { return side; }
+    int size_y() const { return side; }
+    int size_z() const { return dims == 3 ? side : 1; }
+
+    // distance between a point and its farthest neighbour (a line in 2D, a plane in 3D)
+    int halo() const { return dims == 3 ? side * side : side; }
+
+    // sweeps performed by every call of the kernel
+    int time_block() const { return t_block; }
+
+    // the same one for every row
+    float diagonal(int) const { return 2.0f * dims; }
+
+    // Sum of a[i][j]*x[j] for j != i
+    float row_dot(int i, const float *x) const {
+        int gx = i % side, gy = (i / side) % side, gz = i / (side * side);
+        float sum = 0.0;
+        if (gx > 0)
+            sum += x[i - 1];
+        if (gx < side - 1)
+            sum += x[i + 1];
+        if (gy > 0)
+            sum += x[i - side];
+        if (gy < side - 1)
+            sum += x[i + side];
+        if (dims == 3 && gz > 0)
+            sum += x[i - side * side];
+        if (dims == 3 && gz < side - 1)
+            sum += x[i + side * side];
+        return -sum;
+    }
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stream.h"
+
+
+// Alignment of the buffers, of the offsets and of the lengths of the reads, required by O_DIRECT
+constexpr std::size_t PAGE_SIZE = 4096;
+
+// Open the file to read blocks of (at least) block_rows rows
+BlockStream::BlockStream(const std::string &path, const SystemFile &file, int block_rows, int row_multiple) :
+        n(file.rows()), row_stride(file.stride()), a_offset(file.a_offset()), released(0), stop(false) {
+
+    // The blocks bypass the page cache, if the file system does not support O_DIRECT they are read normally
+    fd = open(path.c_str(), O_RDONLY | O_DIRECT);
+    if (fd < 0 && errno == EINVAL)
+        fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+
+    // 64 rows are a multiple of the page size (the rows are multiples of 64 bytes)
+    int multiple = std::lcm(std::max(row_multiple, 1), 64);
+    int max_rows = (n + multiple - 1) / multiple * multiple;
+    n_block_rows = std::min((std::max(block_rows, 1) + multiple - 1) / multiple * multiple, max_rows);
+    n_blocks = (n + n_block_rows - 1) / n_block_rows;
+
+    buffer_size = n_block_rows * row_stride * sizeof(float);
+    for (int i = 0; i < 2; i++) {
+        buffers[i] = static_cast<float*>(::operator new[](buffer_size, std::align_val_t(PAGE_SIZE)));
+        ready[i].store(0);
+    }
+
+    prefetcher = std::thread(&BlockStream::read_blocks, this);
+}
+
+BlockStream::~BlockStream() {
+
+    // wake the prefetcher if it is waiting for a buffer
+    stop = true;
+    released.store(LONG_MAX);
+    released.notify_all();
+    prefetcher.join();
+
+    close(fd);
+    for (int i = 0; i < 2; i++)
+        ::operator delete[](buffers[i], std::align_val_t(PAGE_SIZE));
+}
+
+// Body of the prefetcher: read the block seq in the buffer seq % 2 as soon as the block seq - 2 has been released
+void BlockStream::read_blocks() {
+
+    for (long seq = 0; ; seq++) {
+        long r;
+        while ((r = released.load(std::memory_order_acquire)) < seq - 1)
+            released.wait(r, std::memory_order_acquire);
+        if (stop.load(std::memory_order_acquire))
+            return;
+
+        int slot = seq % 2;
+        int block = seq % n_blocks;
+        int first = block * n_block_rows;
+        int rows = std::min(n_block_rows, n - first);
+
+        // the length is rounded up to the page size, the file always continues after A (b is stored after it)
+        std::size_t length = rows * row_stride * sizeof(float);
+        std::size_t to_read = (length + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+        std::uint64_t offset = a_offset + (std::uint64_t) first * row_stride * sizeof(float);
+
+        std::size_t done = 0;
+        char *dst = reinterpret_cast<char*>(buffers[slot]);
+        while (done < length) {
+            ssize_t got = pread(fd, dst + done, to_read - done, offset + done);
+            if (got <= 0)
+                break;
+            done += got;
+        }
+
+        ready[slot].store(done >= length ? seq + 1 : -1, std::memory_order_release);
+        ready[slot].notify_all();
+    }
+}
+
+// Wait for the block with sequence number seq
+Matrix BlockStream::acquire(long seq) {
+
+    int slot = seq % 2;
+    long r;
+    while ((r = ready[slot].load(std::memory_order_acquire)) != seq + 1) {
+        if (r == -1)
+            throw std::runtime_error("cannot read a block of the system file");
+        ready[slot].wait(r, std::memory_order_acquire);
+    }
+
+    int first = (seq % n_blocks) * n_block_rows;
+    return Matrix(buffers[slot], std::min(n_block_rows, n - first), n, row_stride, first);
+}
+
+// The block with sequence number seq is no longer used
+void BlockStream::release(long seq) {
+
+    released.store(seq + 1, std::memory_order_release);
+    released.notify_all();
+}
@@ -0,0 +1,66 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "matrix.h"
+#include "system_file.h"
+
+
+// Matrix A of a dense system file read from the disk one block of rows at a time, for systems larger than the memory.
+// A thread (the prefetcher) reads the blocks in a cyclic order (0, 1, ..., num_blocks() - 1, 0, 1, ...) in two
+// buffers, so that the next block is read while the current one is used. The file is opened with O_DIRECT (if the file
+// system supports it) so the blocks are not copied in the page cache. The i-th block read has sequence number i: the
+// user calls acquire(i) to wait for it and release(i) when it is no longer needed, for i = 0, 1, 2, ...
+class BlockStream {
+private:
+    int fd;
+    int n;
+    std::size_t row_stride;
+    std::uint64_t a_offset;
+
+    // rows of every block (the last one may be shorter) and number of blocks of A
+    int n_block_rows;
+    int n_blocks;
+
+    // size (in bytes) of each buffer, a multiple of the page size
+    std::size_t buffer_size;
+    float *buffers[2];
+
+    // sequence number + 1 of the block in each buffer, -1 if it could not be read
+    alignas(64) std::atomic<long> ready[2];
+    // number of blocks released by the user, the prefetcher reuses a buffer only after its block has been released
+    alignas(64) std::atomic<long> released;
+    std::atomic<bool> stop;
+
+    std::thread prefetcher;
+
+    // Body of the prefetcher
+    void read_blocks();
+
+public:
+    // Open the file at path (already opened as file) to read blocks of (at least) block_rows rows. The rows of a block
+    // are rounded up to a multiple of row_multiple and of 64 rows, so that every block begins at a multiple of the
+    // page size in the file. Throws std::runtime_error if the file cannot be opened
+    BlockStream(const std::string &path, const SystemFile &file, int block_rows, int row_multiple);
+
+    BlockStream(const BlockStream&) = delete;
+    BlockStream& operator=(const BlockStream&) = delete;
+
+    ~BlockStream();
+
+    int rows() const { return n; }
+    int block_rows() const { return n_block_rows; }
+    int num_blocks() const { return n_blocks; }
+
+    // Wait for the block with sequence number seq and return a view of its rows (with their indices in A), valid
+    // until release(seq). Throws std::runtime_error if the block could not be read
+    Matrix acquire(long seq);
+
+    // The block with sequence number seq is no longer used, its buffer can be reused for the block seq + 2
+    void release(long seq);
+};
+
+#endif
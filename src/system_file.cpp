@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "system_file.h"
+
+
+// Round offset up to a multiple of align
+static std::uint64_t align_up(std::uint64_t offset, std::uint64_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+// Offsets of the arrays of a CSR file, in the order in which they are written
+struct csr_layout {
+    std::uint64_t row_ptr;
+    std::uint64_t col_idx;
+    std::uint64_t values;
+    std::uint64_t end;
+};
+
+static csr_layout csr_offsets(std::uint64_t a_offset, std::uint64_t n, std::uint64_t nnz) {
+    csr_layout l;
+    l.row_ptr = a_offset;
+    l.col_idx = align_up(l.row_ptr + (n + 1) * sizeof(std::uint64_t), 64);
+    l.values = align_up(l.col_idx + nnz * sizeof(std::uint32_t), 64);
+    l.end = l.values + nnz * sizeof(float);
+    return l;
+}
+
+// Check the arrays of a CSR file: the row pointers begin at 0, never decrease and end at nnz, and every column index
+// is a row of A. Otherwise the matrices built from the file would be written out of their bounds
+static bool valid_csr(const std::uint64_t *ptr, const std::uint32_t *col, std::uint64_t n, std::uint64_t nnz) {
+
+    if (ptr[0] != 0 || ptr[n] != nnz)
+        return false;
+    for (std::uint64_t i = 0; i < n; i++)
+        if (ptr[i + 1] < ptr[i])
+            return false;
+    for (std::uint64_t k = 0; k < nnz; k++)
+        if (col[k] >= n)
+            return false;
+    return true;
+}
+
+
+// Map the file at path
+SystemFile::SystemFile(const std::string &path, bool prefetch) : map(nullptr), map_size(0) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t) st.st_size < sizeof(system_header)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a system file");
+    }
+    map_size = st.st_size;
+
+    // the mapping is private and writable, so that the rows can be viewed by a (non const) Matrix, but it is never
+    // written: no page is copied
+    map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        throw std::runtime_error("cannot map " + path);
+
+    std::memcpy(&header, map, sizeof(header));
+
+    // check the header before any array is used: every size is bounded by the size of the file before it is
+    // multiplied, so that no offset can overflow
+    bool valid = std::memcmp(header.magic, SYSTEM_MAGIC, sizeof(SYSTEM_MAGIC)) == 0 &&
+                 header.version == SYSTEM_VERSION &&
+                 (header.format == SYSTEM_DENSE || header.format == SYSTEM_CSR) &&
+                 header.n > 0 && header.n <= INT32_MAX && header.a_offset % 4096 == 0 && header.b_offset % 64 == 0 &&
+                 header.a_offset <= map_size && header.b_offset <= map_size &&
+                 header.n <= (map_size - header.b_offset) / sizeof(float);
+    if (valid && header.format == SYSTEM_DENSE)
+        valid = header.row_stride >= header.n && header.row_stride % (Matrix::alignment / sizeof(float)) == 0 &&
+                header.row_stride <= (map_size - header.a_offset) / sizeof(float) / header.n;
+    if (valid && header.format == SYSTEM_CSR)
+        valid = header.nnz <= map_size && csr_offsets(header.a_offset, header.n, header.nnz).end <= map_size &&
+                valid_csr(row_ptr(), col_idx(), header.n, header.nnz);
+    if (!valid) {
+        munmap(map, map_size);
+        throw std::runtime_error(path + " is not a valid system file (version " + std::to_string(SYSTEM_VERSION) + ")");
+    }
+
+    // every sweep reads the whole A: ask the kernel to start reading the file now
+    if (prefetch)
+        madvise(map, map_size, MADV_WILLNEED);
+}
+
+SystemFile::~SystemFile() {
+    munmap(map, map_size);
+}
+
+// Dense A: a view of the mapped rows. CSR A: a new dense matrix
+Matrix SystemFile::matrix() {
+
+    int n = header.n;
+    if (is_dense())
+        return Matrix(reinterpret_cast<float*>(static_cast<char*>(map) + header.a_offset), n, n, header.row_stride);
+
+    Matrix a(n, n);
+    const std::uint64_t *ptr = row_ptr();
+    const std::uint32_t *col = col_idx();
+    const float *val = values();
+    for (int i = 0; i < n; i++) {
+        std::memset(a.row_ptr(i), 0, a.stride() * sizeof(float));
+        for (std::uint64_t k = ptr[i]; k < ptr[i + 1]; k++)
+            a[i][col[k]] = val[k];
+    }
+    return a;
+}
+
+// CSR A: a sparse matrix in CSR format
+SparseMatrix SystemFile::sparse_matrix() const {
+
+    int n = header.n;
+    const std::uint64_t *ptr = row_ptr();
+    const std::uint32_t *col = col_idx();
+    const float *val = values();
+
+    // the elements on the diagonal are not counted in the rows of the sparse matrix
+    std::vector<std::uint64_t> sparse_ptr(n + 1, 0);
+    for (int i = 0; i < n; i++) {
+        std::uint64_t diag = 0;
+        for (std::uint64_t k = ptr[i]; k < ptr[i + 1]; k++)
+            diag += col[k] == (std::uint32_t) i;
+        sparse_ptr[i + 1] = sparse_ptr[i] + (ptr[i + 1] - ptr[i]) - diag;
+    }
+
+    SparseMatrix a(n, std::move(sparse_ptr));
+    for (int i = 0; i < n; i++) {
+        std::uint64_t e = a.row_ptr()[i];
+        a.set_diagonal(i, 0.0);
+        for (std::uint64_t k = ptr[i]; k < ptr[i + 1]; k++) {
+            if (col[k] == (std::uint32_t) i)
+                a.set_diagonal(i, a.diagonal(i) + val[k]);
+            else {
+                a.col_idx()[e] = col[k];
+                a.values()[e++] = val[k];
+            }
+        }
+    }
+    return a;
+}
+
+const std::uint64_t *SystemFile::row_ptr() const {
+    return reinterpret_cast<const std::uint64_t*>(static_cast<const char*>(map) + header.a_offset);
+}
+
+const std::uint32_t *SystemFile::col_idx() const {
+    csr_layout l = csr_offsets(header.a_offset, header.n, header.nnz);
+    return reinterpret_cast<const std::uint32_t*>(static_cast<const char*>(map) + l.col_idx);
+}
+
+const float *SystemFile::values() const {
+    csr_layout l = csr_offsets(header.a_offset, header.n, header.nnz);
+    return reinterpret_cast<const float*>(static_cast<const char*>(map) + l.values);
+}
+
+const float *SystemFile::b() const {
+    return reinterpret_cast<const float*>(static_cast<const char*>(map) + header.b_offset);
+}
+
+
+// Write size bytes of data, then zeros up to the offset end
+static void write_padded(std::ofstream &out, const void *data, std::size_t size, std::uint64_t end) {
+    static const char zeros[4096] = {};
+    out.write(static_cast<const char*>(data), size);
+    for (std::uint64_t pos = out.tellp(); pos < end; pos = out.tellp())
+        out.write(zeros, std::min<std::uint64_t>(sizeof(zeros), end - pos));
+}
+
+static system_header make_header(std::uint32_t format, std::uint64_t n) {
+    system_header h = {};
+    std::memcpy(h.magic, SYSTEM_MAGIC, sizeof(SYSTEM_MAGIC));
+    h.version = SYSTEM_VERSION;
+    h.format = format;
+    h.n = n;
+    h.a_offset = 4096;
+    return h;
+}
+
+// Write the dense system (a, b)
+void write_system(const std::string &path, const Matrix &a, const std::vector<float> &b) {
+
+    std::uint64_t n = a.rows();
+    system_header h = make_header(SYSTEM_DENSE, n);
+    h.row_stride = a.stride();
+    h.b_offset = align_up(h.a_offset + n * h.row_stride * sizeof(float), 64);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    write_padded(out, &h, sizeof(h), h.a_offset);
+    for (std::uint64_t i = 0; i < n; i++)
+        write_padded(out, a.row_ptr(i), n * sizeof(float), h.a_offset + (i + 1) * h.row_stride * sizeof(float));
+    write_padded(out, b.data(), n * sizeof(float), h.b_offset + n * sizeof(float));
+
+    if (!out)
+        throw std::runtime_error("cannot write " + path);
+}
+
+// Write the system with A in CSR format
+void write_system_csr(const std::string &path, int n, const std::vector<std::uint64_t> &row_ptr,
+                      const std::vector<std::uint32_t> &col_idx, const std::vector<float> &values,
+                      const std::vector<float> &b) {
+
+    system_header h = make_header(SYSTEM_CSR, n);
+    h.nnz = values.size();
+    csr_layout l = csr_offsets(h.a_offset, n, h.nnz);
+    h.b_offset = align_up(l.end, 64);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    write_padded(out, &h, sizeof(h), l.row_ptr);
+    write_padded(out, row_ptr.data(), (n + 1) * sizeof(std::uint64_t), l.col_idx);
+    write_padded(out, col_idx.data(), h.nnz * sizeof(std::uint32_t), l.values);
+    write_padded(out, values.data(), h.nnz * sizeof(float), h.b_offset);
+    write_padded(out, b.data(), n * sizeof(float), h.b_offset + n * sizeof(float));
+
+    if (!out)
+        throw std::runtime_error("cannot write " + path);
+}
+
+// Write the system with the sparse A, the diagonal is inserted in the rows in the order of the columns
+void write_system(const std::string &path, const SparseMatrix &a, const std::vector<float> &b) {
+
+    int n = a.rows();
+    std::vector<std::uint64_t> row_ptr(n + 1, 0);
+    std::vector<std::uint32_t> col_idx;
+    std::vector<float> values;
+    col_idx.reserve(a.nnz() + n);
+    values.reserve(a.nnz() + n);
+
+    for (int i = 0; i < n; i++) {
+        bool diag = false;
+        for (std::uint64_t k = a.row_ptr()[i]; k < a.row_ptr()[i + 1]; k++) {
+            if (!diag && a.col_idx()[k] > (std::uint32_t) i) {
+                col_idx.push_back(i);
+                values.push_back(a.diagonal(i));
+                diag = true;
+            }
+            col_idx.push_back(a.col_idx()[k]);
+            values.push_back(a.values()[k]);
+        }
+        if (!diag) {
+            col_idx.push_back(i);
+            values.push_back(a.diagonal(i));
+        }
+        row_ptr[i + 1] = values.size();
+    }
+
+    write_system_csr(path, n, row_ptr, col_idx, values, b);
+}
@@ -0,0 +1,90 @@
+#ifndef SYSTEM_FILE_H
+#define SYSTEM_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "sparse_matrix.h"
+
+
+// Binary file of a linear system Ax = b (little endian). The file begins with system_header, then:
+//  - dense: A at a_offset, n rows of row_stride floats (row_stride multiple of 16, the padding is zero), i.e. the
+//    layout of Matrix, so the rows can be used directly from the mapped file
+//  - csr: at a_offset the n + 1 row pointers (uint64), then the nnz column indices (uint32) and the nnz values
+//    (float), each array aligned to 64 bytes
+// and b (n floats) at b_offset. a_offset is a multiple of the page size (4096), b_offset a multiple of 64
+struct system_header {
+    char magic[8];          // SYSTEM_MAGIC
+    std::uint32_t version;  // SYSTEM_VERSION
+    std::uint32_t format;   // SYSTEM_DENSE or SYSTEM_CSR
+    std::uint64_t n;        // dimension of the system
+    std::uint64_t row_stride; // dense: distance (in floats) between two consecutive rows
+    std::uint64_t nnz;      // csr: number of nonzero elements
+    std::uint64_t a_offset; // offset (in bytes) of A
+    std::uint64_t b_offset; // offset (in bytes) of b
+    std::uint64_t reserved;
+};
+
+constexpr char SYSTEM_MAGIC[8] = {'J', 'A', 'C', 'O', 'B', 'I', 'S', 'Y'};
+constexpr std::uint32_t SYSTEM_VERSION = 1;
+constexpr std::uint32_t SYSTEM_DENSE = 0;
+constexpr std::uint32_t SYSTEM_CSR = 1;
+
+
+// Linear system read from a file with mmap: nothing is copied or parsed when the file is opened, the pages are read
+// (asynchronously, madvise(MADV_WILLNEED)) while the solver starts. The file stays mapped until the object is
+// destroyed. If A does not fit in memory the pages should not be read in advance, and A is read one block at a time
+// (BlockStream)
+class SystemFile {
+private:
+    void *map;
+    std::size_t map_size;
+    system_header header;
+
+public:
+    // Map the file at path, throws std::runtime_error if it cannot be read or if it is not a valid system file. If
+    // prefetch is false the pages are read only when they are used
+    explicit SystemFile(const std::string &path, bool prefetch = true);
+
+    SystemFile(const SystemFile&) = delete;
+    SystemFile& operator=(const SystemFile&) = delete;
+
+    ~SystemFile();
+
+    int rows() const { return header.n; }
+    bool is_dense() const { return header.format == SYSTEM_DENSE; }
+    std::uint64_t nnz() const { return header.nnz; }
+    // Dense A: distance (in floats) between two consecutive rows, and offset (in bytes) of the first row in the file
+    std::size_t stride() const { return header.row_stride; }
+    std::uint64_t a_offset() const { return header.a_offset; }
+
+    // Dense A: a view of the mapped rows (no copy). CSR A: a new dense matrix filled with the nonzero elements
+    Matrix matrix();
+
+    // CSR A: a sparse matrix in CSR format with the elements of the file (the diagonal is moved to its own vector)
+    SparseMatrix sparse_matrix() const;
+
+    // Arrays of a CSR file (valid only if is_dense() is false)
+    const std::uint64_t *row_ptr() const;
+    const std::uint32_t *col_idx() const;
+    const float *values() const;
+
+    // Vector b
+    const float *b() const;
+};
+
+// Write the dense system (a, b) to the file at path, throws std::runtime_error if it cannot be written
+void write_system(const std::string &path, const Matrix &a, const std::vector<float> &b);
+
+// Write the system with A in CSR format (row_ptr has n + 1 elements) to the file at path
+void write_system_csr(const std::string &path, int n, const std::vector<std::uint64_t> &row_ptr,
+                      const std::vector<std::uint32_t> &col_idx, const std::vector<float> &values,
+                      const std::vector<float> &b);
+
+// Write the system with the sparse A (in CSR format) to the file at path, the diagonal is stored in the rows
+void write_system(const std::string &path, const SparseMatrix &a, const std::vector<float> &b);
+
+#endif
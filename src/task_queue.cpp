@@ -0,0 +1,494 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "task_queue.h"
+#include "topology.h"
+#include "my_timer.cpp"
+
+
+// Return the chunk_schedule called name
+chunk_schedule parse_chunk_schedule(const std::string &name) {
+
+    if (name == "static")
+        return chunk_schedule::static_chunks;
+    if (name == "guided")
+        return chunk_schedule::guided;
+    if (name == "adaptive")
+        return chunk_schedule::adaptive;
+
+    throw std::invalid_argument("unknown chunk schedule " + name);
+}
+
+
+// Start the threads, the chunks are built by prepare
+TaskQueue::TaskQueue(int nw, int csize, const std::vector<int> &thread_cpus, bool stats, chunk_schedule schedule) :
+        nw(nw), num_chunk(0), chunk_size(round_to_block(csize)), schedule(schedule), n(-1), balanced(false),
+        align(ROW_BLOCK), width(0), epoch(0), remaining(0), is_done(false),
+        parked(nw), thread_cpus(thread_cpus), stats(stats), busy_time(nw), sweep(nullptr) {
+
+    measured.wait_time.assign(nw, 0);
+    measured.ex_time.assign(nw, 0);
+
+    bool timed = stats || schedule == chunk_schedule::adaptive;
+    for (int i = 0; i < nw; i++)
+        threads.emplace_back(timed ? &TaskQueue::extract_tasks_stats : &TaskQueue::extract_tasks, this, i);
+}
+
+//Terminate the execution of the threads
+TaskQueue::~TaskQueue() {
+
+    is_done = true;
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_all();
+    for (std::thread &thr : threads)
+        thr.join();
+}
+
+// Wait until every thread sleeps on the current epoch: a thread that has not seen the last phase yet would still
+// insert its chunks in its deque
+void TaskQueue::wait_idle() {
+
+    long e = epoch.load(std::memory_order_relaxed);
+    for (int i = 0; i < nw; i++)
+        while (parked[i].value.load(std::memory_order_acquire) != e)
+            std::this_thread::yield();
+}
+
+// Replace the chunks with the rows bounds[i] ... bounds[i + 1] - 1
+void TaskQueue::set_chunks(const std::vector<int> &bounds, const std::vector<int> &owners) {
+
+    wait_idle();
+
+    num_chunk = bounds.size() - 1;
+    chunks = std::vector<chunk_task>(num_chunk);
+    for (int i = 0; i < num_chunk; i++)
+        chunks[i] = {bounds[i], bounds[i + 1]};
+
+    owner_first = owners;
+    if (owner_first.empty())
+        for (int i = 0; i <= nw; i++)
+            owner_first.push_back((int) ((long) num_chunk * i / nw));
+
+    // The range of a thread has at most num_chunk / nw (rounded up) chunks in a phase of the static schedule, and
+    // the chunks it owns in a whole iteration
+    int capacity = (num_chunk + nw - 1) / nw;
+    for (int i = 0; i < nw; i++)
+        capacity = std::max(capacity, owner_first[i + 1] - owner_first[i]);
+    deques.clear();
+    for (int i = 0; i < nw; i++)
+        deques.push_back(std::make_unique<WSDeque>(capacity));
+}
+
+// Build the chunks from the cost of the rows
+void TaskQueue::build_chunks() {
+
+    int units = cost.size() - 1;
+    auto row = [&](int u) { return std::min(u * align, n); };
+
+    // Cost of chunk_size rows of average cost
+    double target = chunk_size * cost[units] / std::max(n, 1);
+
+    std::vector<int> bounds = {0};
+    std::vector<int> owners;
+    if (schedule == chunk_schedule::static_chunks) {
+        // A chunk is closed as soon as its cost reaches target
+        for (int u = 1, last = 0; u <= units; u++)
+            if (u == units || cost[u] - cost[last] >= target) {
+                bounds.push_back(row(u));
+                last = u;
+            }
+    }
+    else {
+        // The range of the thread t ends where the cost reaches (t + 1)/nw of the total, every chunk of the range has
+        // half of the cost not assigned yet (all of it if less than 2 * target is left)
+        int last = 0;
+        for (int t = 0; t < nw; t++) {
+            owners.push_back(bounds.size() - 1);
+            int end = t == nw - 1 ? units : std::lower_bound(cost.begin() + last, cost.end(),
+                                                             cost[units] * (t + 1) / nw) - cost.begin();
+            while (last < end) {
+                double left = cost[end] - cost[last];
+                int u = end;
+                if (left >= 2 * target)
+                    u = std::lower_bound(cost.begin() + last + 1, cost.begin() + end, cost[last] + left / 2) -
+                        cost.begin();
+                bounds.push_back(row(u));
+                last = u;
+            }
+        }
+        owners.push_back(bounds.size() - 1);
+    }
+    set_chunks(bounds, owners);
+}
+
+// Split n rows in chunks of chunk_size rows
+void TaskQueue::prepare(int n) {
+
+    if (n == this->n && !balanced)
+        return;
+
+    // The cost of a row is 1
+    align = ROW_BLOCK;
+    int units = (n + align - 1) / align;
+    cost.resize(units + 1);
+    for (int u = 0; u <= units; u++)
+        cost[u] = std::min(u * align, n);
+
+    this->n = n;
+    balanced = false;
+    build_chunks();
+}
+
+// Rebuild the chunks of a sparse system balancing the nonzero elements
+void TaskQueue::prepare(const SparseMatrix &a) {
+
+    int n = a.rows();
+    const std::uint64_t *ptr = a.row_ptr();
+
+    // The cost of a row is its number of elements (the diagonal included). The boundaries are multiples of ROW_BLOCK
+    // (and of the windows of sell)
+    align = std::lcm(ROW_BLOCK, a.row_alignment());
+    int units = (n + align - 1) / align;
+    cost.resize(units + 1);
+    for (int u = 0; u <= units; u++) {
+        int end = std::min(u * align, n);
+        cost[u] = ptr[end] + end;
+    }
+
+    this->n = n;
+    balanced = true;
+    build_chunks();
+}
+
+// Retune the chunks from the wait times of the threads in the last iteration: the difference between the longest and
+// the shortest wait is the time lost to the imbalance at the end of the iteration (the time to wake the threads is
+// about the same for all of them). Large imbalance halves the chunks, small imbalance doubles them (fewer tasks to
+// extract and steal)
+void TaskQueue::retune(const std::vector<time_t> &start, time_t elapsed) {
+
+    if (elapsed < ADAPT_MIN_TIME)
+        return;
+
+    time_t max_wait = 0, min_wait = elapsed;
+    for (int i = 0; i < nw; i++) {
+        time_t wait = elapsed - (busy_time[i].value - start[i]);
+        max_wait = std::max(max_wait, wait);
+        min_wait = std::min(min_wait, wait);
+    }
+    double imbalance = (double) (max_wait - min_wait) / elapsed;
+
+    int size = chunk_size;
+    if (imbalance > ADAPT_HIGH)
+        size = std::max(round_to_block(chunk_size / 2), round_to_block(LINE_ROWS));
+    else if (imbalance < ADAPT_LOW)
+        size = std::min(chunk_size * 2, round_to_block((n + nw - 1) / nw));
+    if (size == chunk_size)
+        return;
+
+    chunk_size = size;
+    build_chunks();
+}
+
+// First chunk of the range of the thread num_thr in the chunks first ... last - 1, the chunks it owns in a whole
+// iteration
+int TaskQueue::first_chunk(int first, int last, int num_thr) const {
+
+    if (first == 0 && last == num_chunk)
+        return owner_first[num_thr];
+    return first + (int) ((long) (last - first) * num_thr / nw);
+}
+
+// Rows of the range of chunks of the thread num_thr
+std::vector<row_range> TaskQueue::worker_rows(int num_thr) const {
+
+    check_worker(num_thr);
+    int first = first_chunk(0, num_chunk, num_thr);
+    int last = first_chunk(0, num_chunk, num_thr + 1);
+    if (first == last)
+        return {};
+    return {{chunks[first].first, chunks[last - 1].last}};
+}
+
+// Start a phase with the chunks first ... last - 1
+void TaskQueue::start_phase(int first, int last) {
+
+    // The slot of the new epoch is invalidated before its range is written (as a seqlock), a late thread that reads a
+    // mix of the old and the new range sees a different epoch in the slot
+    long e = epoch.load(std::memory_order_relaxed) + 1;
+    phase_range &phase = phases[e % 2];
+    phase.epoch.store(-1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    phase.first.store(first, std::memory_order_relaxed);
+    phase.last.store(last, std::memory_order_relaxed);
+    phase.epoch.store(e, std::memory_order_release);
+
+    remaining.store(last - first, std::memory_order_relaxed);
+    epoch.fetch_add(1, std::memory_order_release);
+    // Notify the waiting threads
+    epoch.notify_all();
+}
+
+// Wait every thread before starting a new phase
+void TaskQueue::wait_phase() {
+
+    int r;
+    while ((r = remaining.load(std::memory_order_acquire)) != 0)
+        remaining.wait(r, std::memory_order_acquire);
+}
+
+// Execute the t-th task
+void TaskQueue::execute_task(int t) {
+
+    norm_partial *norm = nullptr;
+    if (width != 0) {
+        norm = &norms[(std::size_t) t * width];
+        std::fill(norm, norm + width, norm_partial());
+    }
+    (*sweep)(chunks[t].first, chunks[t].last, norm);
+}
+
+// Insert the range of chunks of the thread in the phase e in its own deque
+bool TaskQueue::seed_deque(int num_thr, long e) {
+
+    // The range is valid only if the slot still belongs to e after it has been read
+    const phase_range &phase = phases[e % 2];
+    if (phase.epoch.load(std::memory_order_acquire) != e)
+        return false;
+    int phase_first = phase.first.load(std::memory_order_relaxed);
+    int phase_last = phase.last.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (phase.epoch.load(std::memory_order_relaxed) != e)
+        return false;
+
+    int first = first_chunk(phase_first, phase_last, num_thr);
+    for (int i = first_chunk(phase_first, phase_last, num_thr + 1) - 1; i >= first; i--)
+        deques[num_thr]->push(i);
+    return true;
+}
+
+// Extract a task from the deque of the thread or steal one from a random victim
+bool TaskQueue::next_task(int num_thr, unsigned &rnd, int &t) {
+
+    if (deques[num_thr]->pop(t))
+        return true;
+
+    // try (at most) nw - 1 random victims, xorshift is enough to choose them
+    for (int i = 1; i < nw; i++) {
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 17;
+        rnd ^= rnd << 5;
+        int victim = (num_thr + 1 + rnd % (nw - 1)) % nw;
+        if (deques[victim]->steal(t))
+            return true;
+    }
+    return false;
+}
+
+// Notify that a task has been completed
+void TaskQueue::complete_task() {
+
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        remaining.notify_one();
+}
+
+// Called after a failed attempt to find a task
+void TaskQueue::backoff(int &failed) {
+
+    if (++failed < 64)
+        cpu_relax();
+    else
+        std::this_thread::yield();
+}
+
+// This function is used by the threads to extract tasks from the queue and to execute them
+void TaskQueue::extract_tasks(int num_thr) {
+
+    if (!thread_cpus.empty())
+        pin_thread(thread_cpus[num_thr]);
+
+    unsigned rnd = num_thr + 1;
+    long seen = 0;
+
+    while(true) {
+        // The thread waits until the caller starts a new phase or the queue is destroyed
+        parked[num_thr].value.store(seen, std::memory_order_release);
+        epoch.wait(seen, std::memory_order_acquire);
+        seen = epoch.load(std::memory_order_acquire);
+        if (is_done.load(std::memory_order_acquire))
+            return;
+
+        // Every phase is seeded once, from the range of the epoch just loaded. If the thread woke up after the end of
+        // the phase (it had no chunks) it skips it and waits for the next one
+        if (!seed_deque(num_thr, seen))
+            continue;
+
+        // Execute tasks until every task of the phase has been completed, the check on the epoch guarantees that the
+        // thread does not miss the beginning of the next phase
+        int t;
+        int failed = 0;
+        while (remaining.load(std::memory_order_acquire) > 0 && epoch.load(std::memory_order_relaxed) == seen) {
+            if (next_task(num_thr, rnd, t)) {
+                execute_task(t);
+                complete_task();
+                failed = 0;
+            }
+            else
+                backoff(failed);
+        }
+    }
+}
+
+// This version also measures the execution time of the thread
+void TaskQueue::extract_tasks_stats(int num_thr) {
+
+    // Timer to measure the time spent by the thread to compute activities
+    my_timer ex_timer;
+
+    if (!thread_cpus.empty())
+        pin_thread(thread_cpus[num_thr]);
+
+    unsigned rnd = num_thr + 1;
+    long seen = 0;
+
+    while(true) {
+        parked[num_thr].value.store(seen, std::memory_order_release);
+        epoch.wait(seen, std::memory_order_acquire);
+        seen = epoch.load(std::memory_order_acquire);
+        if (is_done.load(std::memory_order_acquire))
+            return;
+
+        if (!seed_deque(num_thr, seen))
+            continue;
+
+        int t;
+        int failed = 0;
+        while (remaining.load(std::memory_order_acquire) > 0 && epoch.load(std::memory_order_relaxed) == seen) {
+            if (next_task(num_thr, rnd, t)) {
+                ex_timer.restart_time();
+                execute_task(t);
+                ex_timer.stop_time();
+                // published by complete_task to the caller
+                busy_time[num_thr].value = ex_timer.saved_time();
+                complete_task();
+                failed = 0;
+            }
+            else
+                backoff(failed);
+        }
+    }
+}
+
+// Add the times of the threads during a solve, the time a thread does not spend executing tasks is spent waiting
+void TaskQueue::add_times(const std::vector<time_t> &start, time_t elapsed) {
+
+    for (int i = 0; i < nw; i++) {
+        time_t ex = busy_time[i].value - start[i];
+        measured.ex_time[i] += ex;
+        measured.wait_time[i] += elapsed - ex;
+    }
+}
+
+// Execute the iterations, every iteration is a single phase with all the chunks
+int TaskQueue::run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    this->width = width;
+    this->sweep = &sweep;
+    norms.assign((std::size_t) num_chunk * width, norm_partial());
+
+    my_timer timer, qu_timer;
+    std::vector<time_t> start(nw);
+    if (stats) {
+        for (int i = 0; i < nw; i++)
+            start[i] = busy_time[i].value;
+        timer.start_timer();
+    }
+
+    // Execution time of the threads at the beginning of the iteration, for the adaptive schedule
+    bool adaptive = schedule == chunk_schedule::adaptive;
+    my_timer it_timer;
+    std::vector<time_t> it_start(nw);
+
+    int k = 0;
+    bool stop = false;
+    while (k < n_iter && !stop) {
+        k++;
+        if (adaptive) {
+            for (int i = 0; i < nw; i++)
+                it_start[i] = busy_time[i].value;
+            it_timer.start_timer();
+        }
+
+        // Start a new iteration with all the chunks (measuring the time to refill the queue) and wait every thread
+        // before starting a new iteration
+        if (stats)
+            qu_timer.restart_time();
+        start_phase(0, num_chunk);
+        if (stats)
+            qu_timer.stop_time();
+        wait_phase();
+        time_t it_elapsed = adaptive ? it_timer.get_time() : 0;
+
+        stop = end_iteration(norms, num_chunk);
+
+        // The partial sums have been reduced, the chunks (and their slots) of the next iteration may change
+        if (adaptive && !stop && k < n_iter) {
+            retune(it_start, it_elapsed);
+            norms.resize((std::size_t) num_chunk * width);
+        }
+    }
+
+    if (stats) {
+        add_times(start, timer.get_time());
+        measured.refill += qu_timer.saved_time();
+    }
+    return k;
+}
+
+// Execute the iterations with a phase for each block
+int TaskQueue::run_blocks(int n_iter, int width, int block_rows, const block_fn &begin_block,
+                          const block_fn &end_block, const sweep_fn &sweep, const end_fn &end_iteration) {
+
+    if (balanced || schedule != chunk_schedule::static_chunks || block_rows % chunk_size != 0)
+        throw std::invalid_argument("the blocks must be multiples of the chunks");
+
+    this->width = width;
+    this->sweep = &sweep;
+    norms.assign((std::size_t) num_chunk * width, norm_partial());
+
+    int block_chunks = block_rows / chunk_size;
+    int n_blocks = (num_chunk + block_chunks - 1) / block_chunks;
+
+    my_timer timer, qu_timer;
+    std::vector<time_t> start(nw);
+    if (stats) {
+        for (int i = 0; i < nw; i++)
+            start[i] = busy_time[i].value;
+        timer.start_timer();
+    }
+
+    int k = 0;
+    bool stop = false;
+    while (k < n_iter && !stop) {
+        k++;
+        // A phase for each block, the caller prepares the block (e.g. waits for it to be read) before the phase
+        for (int i = 0; i < n_blocks; i++) {
+            if (stats)
+                qu_timer.restart_time();
+            begin_block(i);
+            start_phase(i * block_chunks, std::min((i + 1) * block_chunks, num_chunk));
+            if (stats)
+                qu_timer.stop_time();
+            wait_phase();
+            end_block(i);
+        }
+
+        stop = end_iteration(norms, num_chunk);
+    }
+
+    if (stats) {
+        add_times(start, timer.get_time());
+        measured.refill += qu_timer.saved_time();
+    }
+    return k;
+}
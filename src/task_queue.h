@@ -0,0 +1,200 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend.h"
+#include "ws_deque.h"
+
+
+// Descriptor of a task of the thread pool: the rows first ... last - 1 of a chunk. The descriptors are built once by
+// prepare and reused at every iteration
+struct chunk_task {
+    int first;
+    int last;
+};
+
+
+// Sizes of the chunks of the thread pool:
+//  - static: every chunk has the rows (or the elements of a sparse A) of csize rows
+//  - guided: every thread owns a range of rows with 1/nw of the work, the chunks of a range halve the work not assigned
+//    yet, down to the work of csize rows: the owner executes the large chunks first and the thieves steal the small
+//    ones at the end of the range, so the last tasks of an iteration are short
+//  - adaptive: guided, and the minimum size of the chunks is retuned between the iterations from the wait times of the
+//    threads (csize is only the starting value)
+enum class chunk_schedule { static_chunks, guided, adaptive };
+
+// Return the chunk_schedule called name (static, guided, adaptive), throws std::invalid_argument if it does not exist
+chunk_schedule parse_chunk_schedule(const std::string &name);
+
+// Imbalance of an iteration (the difference between the longest and the shortest wait of the threads, relative to the
+// iteration time) above which the adaptive schedule halves the chunks, and below which it doubles them
+constexpr double ADAPT_HIGH = 0.10;
+constexpr double ADAPT_LOW = 0.02;
+// Iterations shorter than this (microseconds) are not measured reliably and do not retune the chunks
+constexpr long ADAPT_MIN_TIME = 100;
+
+
+// Thread pool of par_jacobi2: the rows are split in chunks of csize rows and every thread owns a lock-free
+// work-stealing deque (ws_deque.h). At the beginning of every phase a thread inserts in its own deque a contiguous
+// range of chunks, it executes them and then it steals chunks from the deques of random victims. The caller only
+// starts the phases (an atomic epoch counter) and waits the completion of the last chunk (an atomic counter of the
+// remaining chunks). The threads live as long as the queue, between the solves they sleep on the epoch
+class TaskQueue : public Backend {
+private:
+    // One work-stealing deque for each thread
+    std::vector<std::unique_ptr<WSDeque>> deques;
+    int nw;
+
+    // Tasks of every iteration, the deques contain indices of this vector. The thread i owns the chunks
+    // owner_first[i] ... owner_first[i + 1] - 1 of an iteration
+    std::vector<chunk_task> chunks;
+    std::vector<int> owner_first;
+    int num_chunk;
+    // rows of the chunks built by prepare (the minimum with the guided and adaptive schedules)
+    int chunk_size;
+    chunk_schedule schedule;
+    // rows of the system split in chunks (-1 before the first prepare), balanced is true if the chunks have been
+    // balanced by the elements of a sparse A
+    int n;
+    bool balanced;
+    // Work of the rows: cost[u] is the cost of the rows 0 ... u * align - 1 (the number of rows, or of the elements of
+    // a sparse A), the boundaries of the chunks are multiples of align
+    std::vector<double> cost;
+    int align;
+
+    // Chunks first ... last - 1 executed in the phase epoch: every iteration is a single phase with all the chunks,
+    // unless A is read one block at a time (a phase for each block). The chunks of the phase are split among the threads
+    // in contiguous ranges of (almost) the same size. The range of the phase e is published in phases[e % 2] before
+    // the epoch, so a thread that wakes up late reads the range of the epoch it has loaded, or finds that the slot has
+    // been reused (the phase is over)
+    struct phase_range {
+        std::atomic<long> epoch{-1};
+        std::atomic<int> first{0};
+        std::atomic<int> last{0};
+    };
+    phase_range phases[2];
+
+    // partial sums of the stopping criterion, width slots for each chunk
+    std::vector<norm_partial> norms;
+    int width;
+
+    // Number of the current phase, the threads wait on it for a new phase to start
+    alignas(64) std::atomic<long> epoch;
+    // Number of tasks of the current phase that have not been completed yet, the caller waits on it
+    alignas(64) std::atomic<int> remaining;
+
+    std::atomic<bool> is_done;
+
+    // Last epoch seen by each thread before it went to sleep, used to wait for the threads to be idle
+    std::vector<padded<std::atomic<long>>> parked;
+
+    // Cpu of each thread, empty if the threads are not pinned
+    std::vector<int> thread_cpus;
+
+    // Execution time of each thread since its start, measured if stats is true or the schedule is adaptive
+    bool stats;
+    std::vector<padded<time_t>> busy_time;
+
+    // Kernel of the tasks of the current solve
+    const sweep_fn *sweep;
+
+    std::vector<std::thread> threads;
+
+    // Replace the chunks with the rows bounds[i] ... bounds[i + 1] - 1, for every i. The thread i owns the chunks
+    // owners[i] ... owners[i + 1] - 1, if owners is empty every thread owns the same number of chunks
+    void set_chunks(const std::vector<int> &bounds, const std::vector<int> &owners = {});
+
+    // Build the chunks from cost and chunk_size according to the schedule
+    void build_chunks();
+
+    // Retune chunk_size from the execution time of every thread in the last iteration (start[i] is the execution time
+    // of the thread i at its beginning) and rebuild the chunks if it changes. Adaptive schedule only
+    void retune(const std::vector<time_t> &start, time_t elapsed);
+
+    // Wait until every thread sleeps on the current epoch, so that the chunks and the deques can be replaced
+    void wait_idle();
+
+    // First chunk of the range of the thread num_thr in the chunks first ... last - 1
+    int first_chunk(int first, int last, int num_thr) const;
+
+    // Start a phase with the chunks first ... last - 1: the tasks are always the same, so it is enough to reset the
+    // counter of the remaining tasks and to increment the epoch. Every thread inserts its chunks in its own deque
+    void start_phase(int first, int last);
+
+    // Wait every thread before starting a new phase
+    void wait_phase();
+
+    // Execute the t-th task, if width != 0 it also computes the partial sums of the stopping criterion of its chunk
+    void execute_task(int t);
+
+    // Insert the range of chunks of the thread in the phase e in its own deque, in reverse order so that the owner
+    // extracts them in increasing order while the thieves steal from the end of the range. Returns false (and inserts
+    // nothing) if the range of the phase e has already been replaced, i.e. the phase is over
+    bool seed_deque(int num_thr, long e);
+
+    // Extract a task from the deque of the thread or, if it is empty, try to steal one from a random victim. Returns
+    // false if no task has been found
+    bool next_task(int num_thr, unsigned &rnd, int &t);
+
+    // Notify that a task has been completed, the thread completing the last task of the phase wakes the caller
+    void complete_task();
+
+    // Called after a failed attempt to find a task: spin for a while, then yield the CPU (the last tasks of the
+    // iteration may be executed by threads that are not running)
+    void backoff(int &failed);
+
+    // This function is used by the threads to extract tasks from the queue and to execute them
+    void extract_tasks(int num_thr);
+
+    // This version also measures the execution time of the thread
+    void extract_tasks_stats(int num_thr);
+
+    // Add the times of the threads during a solve of elapsed microseconds, start[i] is the execution time of the
+    // thread i at the beginning of the solve
+    void add_times(const std::vector<time_t> &start, time_t elapsed);
+
+public:
+    // Start nw threads, the i-th one pinned on thread_cpus[i] (if it is not empty). The rows will be split in chunks of
+    // csize rows (rounded up to a multiple of ROW_BLOCK) according to schedule. The adaptive schedule measures the
+    // execution time of the threads even without stats
+    TaskQueue(int nw, int csize, const std::vector<int> &thread_cpus, bool stats = false,
+              chunk_schedule schedule = chunk_schedule::static_chunks);
+
+    // Terminate the threads
+    ~TaskQueue();
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    int workers() const override { return nw; }
+
+    // Split n rows in chunks of chunk_size rows (at least, with the guided and adaptive schedules)
+    void prepare(int n) override;
+
+    // Rebuild the chunks of a sparse system so that every chunk has about the nonzero elements of chunk_size rows of
+    // average length, instead of chunk_size rows (and every thread owns 1/nw of the elements with the guided and
+    // adaptive schedules). The chunks of the sell format are whole windows of its rows
+    void prepare(const SparseMatrix &a) override;
+
+    // Rows of the chunks that the thread num_thr executes at the beginning of every iteration, i.e. the rows it will
+    // compute unless they are stolen
+    std::vector<row_range> worker_rows(int num_thr) const override;
+
+    int run(int n_iter, int width, const sweep_fn &sweep, const end_fn &end_iteration) override;
+
+    // Every block is a phase with the chunks of its rows (block_rows is a multiple of the chunk size, static schedule
+    // only), the time to start a phase includes begin_block (e.g. the time spent waiting for a block that has not been
+    // read yet)
+    int run_blocks(int n_iter, int width, int block_rows, const block_fn &begin_block, const block_fn &end_block,
+                   const sweep_fn &sweep, const end_fn &end_iteration) override;
+
+    // Rows of the chunks built by prepare(n), the current minimum with the guided and adaptive schedules
+    int chunk_rows() const { return chunk_size; }
+};
+
+#endif
@@ -25,7 +25,7 @@ auto blockThreads = [](std::condition_variable &cond, std::mutex &ll, bool &awak
 };
 
 
-int main(int argc, char *argv[]) {
+int main(int, char *argv[]) {
 
   int nw = std::stoul(argv[1]); //parallel degree
   int dummy_mode = std::stoul(argv[2]); //if it's 1 activates the dummy mode, otw pass 0
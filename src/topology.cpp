@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "topology.h"
+
+
+// Read an integer from a file of sysfs, return def if the file cannot be read
+static int read_sysfs_int(const std::string &path, int def) {
+
+    std::ifstream in(path);
+    int value;
+    if (in >> value)
+        return value;
+    return def;
+}
+
+// Cpus on which the process is allowed to run
+std::vector<cpu_info> available_cpus() {
+
+    std::vector<cpu_info> cpus;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+        return {{0, 0, 0, 0}};
+
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &mask))
+            continue;
+
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(c);
+        cpu_info info;
+        info.cpu = c;
+        info.package = read_sysfs_int(base + "/topology/physical_package_id", 0);
+        info.core = read_sysfs_int(base + "/topology/core_id", c);
+        // index3 is the L3 cache, if the cpu has not got an L3 the llc is the package
+        info.llc = read_sysfs_int(base + "/cache/index3/id", info.package);
+        cpus.push_back(info);
+    }
+    return cpus;
+}
+
+// Model name of the cpus
+std::string cpu_model() {
+
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line))
+        if (line.rfind("model name", 0) == 0) {
+            std::size_t colon = line.find(':');
+            if (colon != std::string::npos && colon + 2 <= line.size())
+                return line.substr(colon + 2);
+        }
+    return "unknown";
+}
+
+// Cpu on which each of the nw threads is expected to run when the threads are not pinned
+std::vector<int> default_thread_cpus(int nw) {
+
+    std::vector<cpu_info> cpus = available_cpus();
+    std::vector<int> thread_cpus(nw);
+    for (int i = 0; i < nw; i++)
+        thread_cpus[i] = cpus[i % cpus.size()].cpu;
+    return thread_cpus;
+}
+
+
+
+// Parse a list of cpus such as "0,2,4-7", every cpu must be one of the available cpus
+static std::vector<int> parse_cpu_list(const std::string &list, const std::vector<cpu_info> &available) {
+
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::size_t dash = item.find('-');
+        int first, last;
+        try {
+            first = std::stoi(item.substr(0, dash));
+            last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument("invalid affinity " + list);
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+            throw std::invalid_argument("invalid affinity " + list);
+        for (int c = first; c <= last; c++) {
+            if (std::none_of(available.begin(), available.end(), [c](const cpu_info &info) { return info.cpu == c; }))
+                throw std::invalid_argument("the cpu " + std::to_string(c) + " of the affinity " + list +
+                                            " is not available to the process");
+            cpus.push_back(c);
+        }
+    }
+    if (cpus.empty())
+        throw std::invalid_argument("invalid affinity " + list);
+    return cpus;
+}
+
+// Cpus on which the nw threads are pinned according to the affinity policy
+std::vector<int> affinity_cpus(const std::string &policy, int nw) {
+
+    if (policy == "none")
+        return {};
+
+    std::vector<int> order;
+    std::vector<cpu_info> cpus = available_cpus();
+
+    if (policy == "compact") {
+        std::sort(cpus.begin(), cpus.end(), [](const cpu_info &l, const cpu_info &r) {
+            return std::tie(l.package, l.llc, l.core, l.cpu) < std::tie(r.package, r.llc, r.core, r.cpu);
+        });
+        for (const cpu_info &info : cpus)
+            order.push_back(info.cpu);
+    }
+    else if (policy == "scatter") {
+        // rank of every cpu among the hyperthreads of its core (0 for the first one)
+        std::map<std::pair<int, int>, int> seen;
+        std::vector<std::tuple<int, int, int, int>> keys;
+        for (const cpu_info &info : cpus)
+            keys.emplace_back(seen[std::make_pair(info.package, info.core)]++, info.llc, info.core, info.cpu);
+
+        // every socket orders its cpus by hyperthread rank, the sockets are then visited in a round-robin way
+        std::map<int, std::vector<std::tuple<int, int, int, int>>> packages;
+        for (std::size_t i = 0; i < cpus.size(); i++)
+            packages[cpus[i].package].push_back(keys[i]);
+        for (auto &p : packages)
+            std::sort(p.second.begin(), p.second.end());
+
+        for (std::size_t i = 0; order.size() < cpus.size(); i++)
+            for (auto &p : packages)
+                if (i < p.second.size())
+                    order.push_back(std::get<3>(p.second[i]));
+    }
+    else
+        order = parse_cpu_list(policy, cpus);
+
+    std::vector<int> thread_cpus(nw);
+    for (int i = 0; i < nw; i++)
+        thread_cpus[i] = order[i % order.size()];
+    return thread_cpus;
+}
+
+// Cpus on which the calling thread is allowed to run
+std::vector<int> thread_affinity() {
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    std::vector<int> cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask) != 0)
+        return cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &mask))
+            cpus.push_back(c);
+    return cpus;
+}
+
+// Allow the calling thread to run only on cpus
+bool set_thread_affinity(const std::vector<int> &cpus) {
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int c : cpus) {
+        if (c < 0 || c >= CPU_SETSIZE)
+            return false;
+        CPU_SET(c, &mask);
+    }
+    return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
+
+// Pin the calling thread on cpu
+bool pin_thread(int cpu) {
+
+    return set_thread_affinity({cpu});
+}
+
+// Place the pages of A on the NUMA nodes of the threads that will compute them
+void first_touch(Matrix &a, const std::vector<int> &thread_cpus, const std::vector<std::vector<row_range>> &rows) {
+
+    std::vector<std::thread> tvec;
+    for (std::size_t t = 0; t < std::min(thread_cpus.size(), rows.size()); t++) {
+        tvec.emplace_back([&, t]() {
+            pin_thread(thread_cpus[t]);
+            for (const row_range &r : rows[t])
+                if (r.first < r.last)
+                    std::memset(a.row_ptr(r.first), 0, (r.last - r.first) * a.stride() * sizeof(float));
+        });
+    }
+
+    for (std::thread &thr : tvec)
+        thr.join();
+}
@@ -0,0 +1,56 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+
+
+// Position of a cpu (hardware thread) in the topology of the machine, read from /sys/devices/system/cpu
+struct cpu_info {
+    int cpu;     // number of the cpu
+    int package; // socket
+    int llc;     // last level cache shared by the cpu (id unique in the package)
+    int core;    // physical core (id unique in the package)
+};
+
+// Cpus on which the process is allowed to run, in increasing order. If the topology cannot be read, every cpu is
+// considered a different core of the same package and llc
+std::vector<cpu_info> available_cpus();
+
+// Model name of the cpus (the first "model name" of /proc/cpuinfo), "unknown" if it cannot be read
+std::string cpu_model();
+
+// Cpu on which each of the nw threads of a parallel program is expected to run when the threads are not pinned: the
+// thread i runs on the i-th available cpu (modulo the number of available cpus)
+std::vector<int> default_thread_cpus(int nw);
+
+// Cpus on which the nw threads of a parallel program are pinned according to the affinity policy:
+//  - none: the threads are not pinned, the returned vector is empty
+//  - compact: the threads fill the cpus of a core, then the cores of a last level cache, then the sockets
+//  - scatter: consecutive threads are spread over the sockets, and over the cores before the hyperthreads of a core
+//  - a list of cpus such as "0,2,4-7": the thread i is pinned on the (i mod size)-th cpu of the list
+// If there are more threads than cpus the cpus are reused in the same order. Throws std::invalid_argument if the
+// policy cannot be parsed or a cpu of the list is not available to the process, so that the threads are never pinned
+// on an invalid cpu
+std::vector<int> affinity_cpus(const std::string &policy, int nw);
+
+// Cpus on which the calling thread is allowed to run (empty if they cannot be read)
+std::vector<int> thread_affinity();
+
+// Allow the calling thread to run only on cpus (e.g. to restore the cpus of thread_affinity after pin_thread),
+// returns false if it is not possible
+bool set_thread_affinity(const std::vector<int> &cpus);
+
+// Pin the calling thread on cpu. It does not throw (it is called by the worker threads), returns false if the thread
+// cannot be pinned and then it keeps running on its previous cpus
+bool pin_thread(int cpu);
+
+// Place the pages of A on the NUMA nodes of the threads that will compute them: the thread t, pinned on
+// thread_cpus[t], writes the rows rows[t] before A is initialized, so that with the first-touch policy of Linux every
+// page is allocated on the node of the cpu of the thread (for t < min(thread_cpus.size(), rows.size())). Does nothing if
+// thread_cpus is empty (threads not pinned)
+void first_touch(Matrix &a, const std::vector<int> &thread_cpus, const std::vector<std::vector<row_range>> &rows);
+
+#endif
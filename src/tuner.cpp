@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "tuner.h"
+#include "topology.h"
+#include "my_timer.cpp"
+
+
+// Name of a partition_kind, as accepted by parse_partition
+static std::string partition_name(partition_kind part) {
+
+    switch (part) {
+        case partition_kind::block_cyclic:
+            return "block_cyclic";
+        case partition_kind::cyclic:
+            return "cyclic";
+        default:
+            return "block";
+    }
+}
+
+// Key of the tuning cache
+std::string tune_key(const std::string &matrix_kind, int n) {
+
+    int size_class = n > 0 ? (int) std::log2(n) : 0;
+    return cpu_model() + "|" + std::to_string(available_cpus().size()) + "|" + matrix_kind + "|" +
+           std::to_string(size_class);
+}
+
+// Every line of the cache is a configuration: key, backend, nw, partition, bsize, chunk, schedule and time separated by
+// tabs. A malformed line (or one of a backend not available in this program) is ignored, as if the key were missing
+std::optional<tuned_config> load_tuned(const std::string &path, const std::string &key) {
+
+    std::vector<std::string> names = backend_names();
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string k, part;
+        tuned_config conf;
+        if (!std::getline(fields, k, '\t') || k != key)
+            continue;
+        if (!(fields >> conf.backend >> conf.cfg.nw >> part >> conf.cfg.bsize >> conf.cfg.chunk >> conf.cfg.schedule >>
+              conf.time))
+            continue;
+        if (std::find(names.begin(), names.end(), conf.backend) == names.end() || conf.cfg.nw < 1 ||
+            conf.cfg.bsize < 1 || conf.cfg.chunk < 0)
+            continue;
+        try {
+            conf.cfg.part = parse_partition(part);
+        }
+        catch (const std::invalid_argument &) {
+            continue;
+        }
+        return conf;
+    }
+    return std::nullopt;
+}
+
+// Copy the tuned fields of conf in cfg
+void apply_tuned(const tuned_config &conf, backend_config &cfg) {
+
+    cfg.nw = conf.cfg.nw;
+    cfg.part = conf.cfg.part;
+    cfg.bsize = conf.cfg.bsize;
+    cfg.chunk = conf.cfg.chunk;
+    cfg.schedule = conf.cfg.schedule;
+}
+
+// Store the configuration of key
+void save_tuned(const std::string &path, const std::string &key, const tuned_config &conf) {
+
+    // The lines of the other keys are kept
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+            if (line.substr(0, line.find('\t')) != key)
+                lines.push_back(line);
+    }
+
+    std::ostringstream entry;
+    entry << key << '\t' << conf.backend << '\t' << conf.cfg.nw << '\t' << partition_name(conf.cfg.part) << '\t'
+          << conf.cfg.bsize << '\t' << conf.cfg.chunk << '\t' << conf.cfg.schedule << '\t' << conf.time;
+    lines.push_back(entry.str());
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (const std::string &line : lines)
+            out << line << '\n';
+        if (!out)
+            throw std::runtime_error("cannot write " + tmp);
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("cannot rename " + tmp + " to " + path);
+}
+
+// Sizes (in rows) tried for n rows and nw threads: the values of scale that leave at least one piece to every thread,
+// the first one always
+static std::vector<int> piece_sizes(int n, int nw, const std::vector<int> &scale) {
+
+    std::vector<int> sizes;
+    for (int rows : scale)
+        if (sizes.empty() || ((long) rows * nw <= n && std::find(sizes.begin(), sizes.end(), rows) == sizes.end()))
+            sizes.push_back(rows);
+    return sizes;
+}
+
+// Configurations tried by the calibration
+std::vector<tuned_config> tune_candidates(int n, const backend_config &cfg, const std::string &affinity) {
+
+    std::vector<std::string> names = backend_names();
+    bool has_ff = std::find(names.begin(), names.end(), "ff") != names.end();
+
+    std::vector<tuned_config> candidates;
+    candidates.push_back({"seq", backend_config()});
+
+    int max_nw = cfg.nw;
+    std::vector<int> degrees;
+    for (int nw = 2; nw < max_nw; nw *= 2)
+        degrees.push_back(nw);
+    if (max_nw > 1)
+        degrees.push_back(max_nw);
+
+    for (int nw : degrees) {
+        // The options that are not tuned (barrier, spin, spin_wait) are the ones of the program, so every candidate is
+        // measured as it will run
+        backend_config base = cfg;
+        base.nw = nw;
+        base.thread_cpus = affinity_cpus(affinity, nw);
+
+        // The blocks of the block_cyclic partitioning are 1, 4 and 16 cache lines of x, the chunks 1/4, 1/16 and 1/64 of
+        // the rows of a thread (rounded up to a cache line of x)
+        std::vector<int> bsizes = piece_sizes(n, nw, {LINE_ROWS, 4 * LINE_ROWS, 16 * LINE_ROWS});
+        std::vector<int> chunks;
+        for (int div : {4, 16, 64})
+            chunks.push_back(std::max(LINE_ROWS, (n / nw / div + LINE_ROWS - 1) / LINE_ROWS * LINE_ROWS));
+        chunks = piece_sizes(n, nw, chunks);
+
+        auto add = [&](const std::string &backend, partition_kind part, int bsize, int chunk,
+                       const std::string &schedule) {
+            tuned_config conf{backend, base};
+            conf.cfg.part = part;
+            conf.cfg.bsize = bsize;
+            conf.cfg.chunk = chunk;
+            conf.cfg.schedule = schedule;
+            candidates.push_back(conf);
+        };
+        add("barrier", partition_kind::block, DEFAULT_BSIZE, 0, "static");
+        for (int bsize : bsizes)
+            add("barrier", partition_kind::block_cyclic, bsize, 0, "static");
+        for (int chunk : chunks)
+            add("tasks", partition_kind::block, DEFAULT_BSIZE, chunk, "static");
+        add("tasks", partition_kind::block, DEFAULT_BSIZE, LINE_ROWS, "adaptive");
+        add("omp", partition_kind::block, DEFAULT_BSIZE, 0, "static");
+        for (int chunk : chunks)
+            add("omp", partition_kind::block, DEFAULT_BSIZE, chunk, "dynamic");
+        add("omp", partition_kind::block, DEFAULT_BSIZE, LINE_ROWS, "guided");
+        add("pstl", partition_kind::block, DEFAULT_BSIZE, 0, "static");
+        for (int chunk : chunks)
+            add("pstl", partition_kind::block, DEFAULT_BSIZE, chunk, "static");
+        if (has_ff) {
+            add("ff", partition_kind::block, DEFAULT_BSIZE, 0, "static");
+            for (int chunk : chunks)
+                add("ff", partition_kind::block, DEFAULT_BSIZE, chunk, "static");
+        }
+    }
+    return candidates;
+}
+
+// Return the fastest of the candidates
+tuned_config calibrate(const std::vector<tuned_config> &candidates, const std::function<void(JacobiSolver &)> &solve) {
+
+    tuned_config best;
+    for (const tuned_config &conf : candidates) {
+        JacobiSolver solver(make_backend(conf.backend, conf.cfg));
+
+        long fastest = -1;
+        for (int r = 0; r < TUNE_RUNS; r++) {
+            my_timer timer;
+            timer.start_timer();
+            solve(solver);
+            long elapsed = timer.get_time();
+            if (fastest < 0 || elapsed < fastest)
+                fastest = elapsed;
+        }
+
+        if (best.backend.empty() || fastest < best.time) {
+            best = conf;
+            best.time = fastest;
+        }
+    }
+    return best;
+}
+
+// Description of a configuration
+std::string describe(const tuned_config &conf) {
+
+    std::ostringstream out;
+    out << "backend=" << conf.backend << " nw=" << conf.cfg.nw;
+    if (conf.backend == "barrier")
+        out << " partition=" << partition_name(conf.cfg.part);
+    if (conf.backend == "barrier" && conf.cfg.part == partition_kind::block_cyclic)
+        out << " bsize=" << conf.cfg.bsize;
+    if (conf.backend == "tasks" || conf.backend == "omp" || conf.backend == "pstl" || conf.backend == "ff")
+        out << " chunk=" << conf.cfg.chunk;
+    if (conf.backend == "tasks" || conf.backend == "omp")
+        out << " schedule=" << conf.cfg.schedule;
+    return out.str();
+}
@@ -0,0 +1,61 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "backends.h"
+#include "solver.h"
+
+
+// Iterations of a calibration run and runs of every candidate (the fastest one is kept, the first run also warms up
+// the threads and the caches)
+constexpr int TUNE_ITER = 10;
+constexpr int TUNE_RUNS = 3;
+
+// Tuning cache used when the program does not specify it
+const std::string DEFAULT_TUNE_CACHE = "jacobi_tune.cache";
+
+// Configuration of the execution: a backend (make_backend) and its parameters
+struct tuned_config {
+    std::string backend;
+    backend_config cfg;
+    // time of a calibration run (microseconds), 0 if not measured
+    long time = 0;
+};
+
+// Key of the tuning cache for a system of n unknowns with matrix kind: the model of the cpus, the number of available
+// cpus, the kind and the size class of the system (floor(log2(n))), since the best configuration changes with each
+std::string tune_key(const std::string &matrix_kind, int n);
+
+// Configuration stored in the cache file path for key, if any (a malformed line of the key is ignored)
+std::optional<tuned_config> load_tuned(const std::string &path, const std::string &key);
+
+// Copy the tuned parameters of conf (parallel degree, partitioning, block size, chunk and schedule) in cfg, the
+// parameters chosen by the user (barrier, spin, spin_wait, stats) are kept. The cpus of the threads are not copied,
+// they depend on the parallel degree
+void apply_tuned(const tuned_config &conf, backend_config &cfg);
+
+// Store the configuration of key in the cache file path, replacing the previous one. The file is rewritten and renamed,
+// so a concurrent reader sees either the old or the new cache
+void save_tuned(const std::string &path, const std::string &key, const tuned_config &conf);
+
+// Configurations tried by the calibration on a system of n unknowns with at most max_nw threads: the sequential backend,
+// then for every parallel degree nw (powers of 2 up to max_nw, and max_nw) the barrier backend with block and
+// block_cyclic partitioning (blocks of 1, 4 and 16 cache lines of x), the task queue with static chunks and adaptive
+// chunks, OpenMP with static, dynamic and guided scheduling, the parallel STL and FastFlow (if available) with nw
+// contiguous ranges and with chunks. The chunks are 1/4, 1/16 and 1/64 of the n/nw rows of a thread; the sizes that
+// would leave a thread without rows are skipped. max_nw is cfg.nw, the other options of the backends not listed here
+// (barrier, spin, spin_wait, stats) are taken from cfg. The threads are pinned according to the affinity policy
+std::vector<tuned_config> tune_candidates(int n, const backend_config &cfg, const std::string &affinity);
+
+// Return the fastest of the candidates: solve runs TUNE_ITER iterations with the solver built on a candidate, it is
+// executed TUNE_RUNS times for every candidate
+tuned_config calibrate(const std::vector<tuned_config> &candidates, const std::function<void(JacobiSolver &)> &solve);
+
+// Description of a configuration, as printed by the programs
+std::string describe(const tuned_config &conf);
+
+#endif
@@ -1,56 +1,182 @@
+#include <algorithm>
 #include <iostream>
 #include <cmath>
-#include <random>
+#include <thread>
 #include <vector>
 #include <climits>
+#include <string>
 
 #include "utils.h"
+#include "implicit_matrix.h"
+#include "sparse_matrix.h"
+#include "stencil.h"
+#include "rhs_batch.h"
 
 
-// This function initiliazes the elements of the matrix A and the vector b
-void initialize_problem(int n, std::vector<std::vector<float>> &a, std::vector<float> &b, float min_value, float max_value) {
-    
-    
-    // Random initialization of matrix A
-    for(int i = 0; i < n; i++) {
-        for(int j = 0; j < n; j++) {
-            a[i][j] = min_value + static_cast<float> (rand() / static_cast<float>(RAND_MAX/(max_value-min_value)));
-        }
+// Return the value of the optional argument --name=value passed to the program, or def if it has not been passed
+std::string get_option(int argc, char *argv[], const std::string &name, const std::string &def) {
+
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0)
+            return arg.substr(prefix.size());
     }
-    
-    
-    
-    // Transform matrix A into a strictly diagonally matrix
-    float sum;
-    for(int i = 0; i <n; i++) {
-        // Store the absolute sum of the i-th row
-        sum = 0.0;
-        
-        for(int j = 0; j < n; j++) {
-            sum += std::abs(a[i][j]);
-        }
-        sum -= std::abs(a[i][i]);
-        
-        //check if the elements on the diagonal has to be modified
-        if (std::abs(a[i][i]) <= sum){
-            if (a[i][i] < 0) 
-                a[i][i] = -sum - 10;
-            else
-                a[i][i] = sum + 10;
-        }
+    return def;
+}
+
+// Generate the i-th row of A and return b[i]
+float generate_row(int n, int i, float *row, float min_value, float max_value, std::uint64_t seed) {
+
+    std::uint64_t base = (std::uint64_t) i * (n + 1);
+
+    // Random initialization of the row, storing its absolute sum
+    float sum = 0.0;
+    for (int j = 0; j < n; j++) {
+        row[j] = counter_random(seed, base + j, min_value, max_value);
+        sum += std::abs(row[j]);
     }
-    
-    // Random initialization of vector b
-    for (int i = 0; i < n; i++){
-        b[i] = min_value + static_cast<float> (rand() / static_cast<float>(RAND_MAX/(max_value-min_value)));;
+    sum -= std::abs(row[i]);
+
+    // check if the element on the diagonal has to be modified to make the row strictly diagonally dominant
+    if (std::abs(row[i]) <= sum) {
+        if (row[i] < 0)
+            row[i] = -sum - 10;
+        else
+            row[i] = sum + 10;
     }
-    
+
+    return counter_random(seed, base + n, min_value, max_value);
+}
+
+// This function initiliazes the elements of the matrix A and the vector b
+void initialize_problem(int n, Matrix &a, std::vector<float> &b, float min_value, float max_value, std::uint64_t seed,
+                        int nw) {
+
+    // Every row is generated (and made diagonally dominant) in a single pass, the threads compute contiguous blocks of
+    // rows
+    auto generate = [&](int thr_n) {
+        int last = (long) n * (thr_n + 1) / nw;
+        for (int i = (long) n * thr_n / nw; i < last; i++)
+            b[i] = generate_row(n, i, a.row_ptr(i), min_value, max_value, seed);
+    };
+
+    std::vector<std::thread> tvec;
+    for (int i = 1; i < nw; i++)
+        tvec.emplace_back(generate, i);
+    generate(0);
+
+    for (std::thread &thr : tvec)
+        thr.join();
+}
+
+// Initialize the diagonal of the matrix-free A and the vector b
+void initialize_problem(int n, ImplicitMatrix &a, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw) {
+
+    a.set_generator(seed, min_value, max_value);
+
+    // Every thread generates its rows one at a time in a buffer of n elements, to compute the diagonal
+    auto generate = [&](int thr_n) {
+        std::vector<float> row(n);
+        int last = (long) n * (thr_n + 1) / nw;
+        for (int i = (long) n * thr_n / nw; i < last; i++) {
+            b[i] = generate_row(n, i, row.data(), min_value, max_value, seed);
+            a.set_diagonal(i, row[i]);
+        }
+    };
+
+    std::vector<std::thread> tvec;
+    for (int i = 1; i < nw; i++)
+        tvec.emplace_back(generate, i);
+    generate(0);
+
+    for (std::thread &thr : tvec)
+        thr.join();
+}
+
+// Initialize the sparse A (row_nnz elements besides the diagonal in every row) and the vector b
+void initialize_problem(int n, SparseMatrix &a, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw) {
+
+    // The columns are drawn (without repetitions and without the diagonal) from a second stream of random bits
+    std::uint64_t col_key = mix64(~seed);
+    int k = a.row_nnz(0);
+
+    auto generate = [&](int thr_n) {
+        int last = (long) n * (thr_n + 1) / nw;
+        for (int i = (long) n * thr_n / nw; i < last; i++) {
+            std::uint32_t *col = a.col_idx() + a.row_ptr()[i];
+            float *val = a.values() + a.row_ptr()[i];
+
+            int found = 0;
+            for (std::uint64_t t = (std::uint64_t) i << 32; found < k; t++) {
+                std::uint32_t j = mix64(col_key + (t + 1) * 0x9e3779b97f4a7c15ULL) % n;
+                if ((int) j != i && std::find(col, col + found, j) == col + found)
+                    col[found++] = j;
+            }
+            std::sort(col, col + k);
+
+            // the values of the row are the counters i*(k + 2) ... i*(k + 2) + k - 1, the diagonal the next one and
+            // b[i] the last one
+            std::uint64_t base = (std::uint64_t) i * (k + 2);
+            float sum = 0.0;
+            for (int e = 0; e < k; e++) {
+                val[e] = counter_random(seed, base + e, min_value, max_value);
+                sum += std::abs(val[e]);
+            }
+            float d = counter_random(seed, base + k, min_value, max_value);
+            if (std::abs(d) <= sum)
+                d = d < 0 ? -sum - 10 : sum + 10;
+            a.set_diagonal(i, d);
+            b[i] = counter_random(seed, base + k + 1, min_value, max_value);
+        }
+    };
+
+    std::vector<std::thread> tvec;
+    for (int i = 1; i < nw; i++)
+        tvec.emplace_back(generate, i);
+    generate(0);
+
+    for (std::thread &thr : tvec)
+        thr.join();
+}
+
+// Initialize the vector b of a stencil, A is only the type of the system
+void initialize_problem(int n, StencilMatrix &, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw) {
+
+    // b[i] depends only on its counter, the threads compute contiguous blocks of b
+    auto generate = [&](int thr_n) {
+        int last = (long) n * (thr_n + 1) / nw;
+        for (int i = (long) n * thr_n / nw; i < last; i++)
+            b[i] = counter_random(seed, i, min_value, max_value);
+    };
+
+    std::vector<std::thread> tvec;
+    for (int i = 1; i < nw; i++)
+        tvec.emplace_back(generate, i);
+    generate(0);
+
+    for (std::thread &thr : tvec)
+        thr.join();
 }
 
+// Initialize the right-hand sides of a batch, the column 0 is b
+void initialize_rhs(int n, RhsBatch &batch, const std::vector<float> &b, float min_value, float max_value,
+                    std::uint64_t seed) {
+
+    for (int i = 0; i < n; i++) {
+        float *bi = batch.b().row_ptr(i);
+        bi[0] = b[i];
+        for (int c = 1; c < batch.size(); c++)
+            bi[c] = counter_random(seed + ((std::uint64_t) c << 32), i, min_value, max_value);
+    }
+}
 
 // Compute the stopping criterion to understand if Jacobi has achieved convergence.
 // Executed iff ch_conv = 1
-float compute_norm(std::vector<float>& x, std::vector<float>& xo, int n) {
+float compute_norm(aligned_vector &x, aligned_vector &xo, int n) {
     
     // This function computes the stopping criterion ||x - x_old||/||x|| if ch_conv == 1
     float num = 0.0;
@@ -70,7 +196,7 @@ float compute_norm(std::vector<float>& x, std::vector<float>& xo, int n) {
 
 
 //OPTIONAL you can use this function to print the system created
-void print_system(int n, std::vector<std::vector<float>> &a, std::vector<float> &b) {
+void print_system(int n, Matrix &a, std::vector<float> &b) {
     
     std::cout << std::endl;
     std::cout << "printing the matrix A" << std::endl;
@@ -99,7 +225,7 @@ void print_system(int n, std::vector<std::vector<float>> &a, std::vector<float>
 }
 
 // OPTIONAL, this function checks the error at the end of Jacobi
-void check_error(int n, std::vector<std::vector<float>> &a, std::vector<float> &b, std::vector<float> &x) {
+void check_error(int n, Matrix &a, std::vector<float> &b, aligned_vector &x) {
     
     float err;
     for(int i = 0; i < n; i++) {
@@ -112,9 +238,61 @@ void check_error(int n, std::vector<std::vector<float>> &a, std::vector<float> &
     }
 }
 
+void check_error(int n, ImplicitMatrix &a, std::vector<float> &b, aligned_vector &x) {
+
+    std::vector<float> row(n);
+    float err;
+    for(int i = 0; i < n; i++) {
+        a.generate(i, 0, n, row.data());
+        err = 0.0;
+        for(int j = 0; j < n; j++){
+            err = row[j]*x[j] + err;
+        }
+        err = err - b[i];
+        std::cout << "Error at row i " << err << std::endl;
+    }
+}
+
+void check_error(int n, SparseMatrix &a, std::vector<float> &b, aligned_vector &x) {
+
+    float err;
+    for(int i = 0; i < n; i++) {
+        err = a.row_dot(i, x.data()) + a.diagonal(i)*x[i];
+        err = err - b[i];
+        std::cout << "Error at row i " << err << std::endl;
+    }
+}
+
+void check_error(int n, StencilMatrix &a, std::vector<float> &b, aligned_vector &x) {
+
+    float err;
+    for(int i = 0; i < n; i++) {
+        err = a.row_dot(i, x.data()) + a.diagonal(i)*x[i];
+        err = err - b[i];
+        std::cout << "Error at row i " << err << std::endl;
+    }
+}
+
+// The error of every right-hand side of a batch (the columns of B are permuted, the solutions are not)
+void check_error(int n, Matrix &a, RhsBatch &batch) {
+
+    float err;
+    for (int p = 0; p < batch.size(); p++) {
+        int c = batch.column(p);
+        for(int i = 0; i < n; i++) {
+            err = 0.0;
+            for(int j = 0; j < n; j++){
+                err = a[i][j]*batch.solution().row_ptr(j)[c] + err;
+            }
+            err = err - batch.b().row_ptr(i)[p];
+            std::cout << "Error at column " << c << " row i " << err << std::endl;
+        }
+    }
+}
+
 // This function is used by the program par_jacobi.cpp (barriers) to compute: the time spent to execute subtasks and to
 // wait on the barrier by each thread
-void barrier_elapsed_time(std::vector<time_t> &wait_time, std::vector<time_t> &tot_wait_time,
+void barrier_elapsed_time(std::vector<padded<time_t>> &wait_time, std::vector<time_t> &tot_wait_time,
                           std::vector<time_t> &tot_ex_time) {
 
     time_t max_wt = LONG_MIN; // Maximum waiting time
@@ -123,14 +301,14 @@ void barrier_elapsed_time(std::vector<time_t> &wait_time, std::vector<time_t> &t
 
     for (int i = 0; i < n; i++) {
 
-        if (wait_time[i] > max_wt)
-            max_wt = wait_time[i];
+        if (wait_time[i].value > max_wt)
+            max_wt = wait_time[i].value;
     }
 
     for (int i = 0; i < n; i++) {
 
-        tot_ex_time[i] += wait_time[i];
-        tot_wait_time[i] += max_wt - wait_time[i];
+        tot_ex_time[i] += wait_time[i].value;
+        tot_wait_time[i] += max_wt - wait_time[i].value;
     }
 
 }
@@ -1,25 +1,106 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <cstdint>
+#include <string>
 #include <vector>
 
+#include "matrix.h"
+
 using time_t = long int;
 
+class ImplicitMatrix;
+class SparseMatrix;
+class StencilMatrix;
+class RhsBatch;
+
+
+// Value alone on its cache line, used for the per-thread slots written at every iteration (e.g. the waiting times of
+// par_jacobi), so that the threads never write on the same line
+template <typename T>
+struct alignas(64) padded {
+    T value{};
+};
+
+
+// Hint to the CPU that the thread is spinning on a shared variable
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+
+// Return the value of the optional argument --name=value passed to the program (the optional arguments follow the
+// positional ones), or def if it has not been passed
+std::string get_option(int argc, char *argv[], const std::string &name, const std::string &def);
+
+// Finalizer of SplitMix64, a bijective mix of the 64 bits of z
+inline std::uint64_t mix64(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
 
-// Initialize the matrices A and b of the linear system
-void initialize_problem(int n, std::vector<std::vector<float>> &a, std::vector<float> &b, float min_value, float max_value);
+// Counter-based random bits: the highest 24 bits of the SplitMix64 mix of the counter, key is mix64(seed)
+inline std::uint32_t counter_bits(std::uint64_t key, std::uint64_t counter) {
+    return mix64(key + (counter + 1) * 0x9e3779b97f4a7c15ULL) >> 40;
+}
+
+// Counter-based random number in [min_value, max_value): the value depends only on the seed and on the counter, so the
+// elements of the linear system can be generated in any order and by any number of threads
+inline float counter_random(std::uint64_t seed, std::uint64_t counter, float min_value, float max_value) {
+    // the 24 bits fill the mantissa of a float in [0, 1)
+    float u = static_cast<float>(counter_bits(mix64(seed), counter)) * 0x1p-24f;
+    return min_value + u * (max_value - min_value);
+}
+
+// Generate the i-th row of the (strictly diagonally dominant) matrix A in row and return b[i]. The element a[i][j] is
+// the random number of counter i*(n + 1) + j, b[i] the one of counter i*(n + 1) + n
+float generate_row(int n, int i, float *row, float min_value, float max_value, std::uint64_t seed);
+
+// Initialize the matrices A and b of the linear system using nw threads, the result depends only on the seed
+void initialize_problem(int n, Matrix &a, std::vector<float> &b, float min_value, float max_value, std::uint64_t seed,
+                        int nw = 1);
+
+// Initialize the diagonal of the matrix-free A (the other elements are regenerated on the fly) and the vector b, the
+// elements are the same ones of the Matrix initialized with the same seed
+void initialize_problem(int n, ImplicitMatrix &a, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw = 1);
+
+// Initialize the sparse A, whose rows have row_nnz random elements (in random columns) besides the diagonal, and the
+// vector b. As for the dense A the result depends only on the seed
+void initialize_problem(int n, SparseMatrix &a, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw = 1);
+
+// Initialize the vector b of the Poisson problem of a stencil (A is not stored) using nw threads, b[i] is the random
+// number of counter i
+void initialize_problem(int n, StencilMatrix &, std::vector<float> &b, float min_value, float max_value,
+                        std::uint64_t seed, int nw = 1);
+
+// Initialize the right-hand sides of a batch: the column 0 is b, the column c > 0 is the random vector of counters
+// 0 ... n - 1 of the seed seed + c*2^32
+void initialize_rhs(int n, RhsBatch &batch, const std::vector<float> &b, float min_value, float max_value,
+                    std::uint64_t seed);
 
 // Compute the stopping criterion to understand if Jacobi has achieved convergence.
 // Executed iff ch_conv = 1
-float compute_norm(std::vector<float>& x, std::vector<float>& xo, int n);
+float compute_norm(aligned_vector &x, aligned_vector &xo, int n);
 
 
 // OPTIONAL, print the matrices A and b of the linear system
-void print_system(int n, std::vector<std::vector<float>> &a, std::vector<float> &b);
+void print_system(int n, Matrix &a, std::vector<float> &b);
 
 // OPTIONAL, this function checks the error at the end of Jacobi
-void check_error(int n, std::vector<std::vector<float>> &a, std::vector<float> &b, std::vector<float> &x);
+void check_error(int n, Matrix &a, std::vector<float> &b, aligned_vector &x);
+void check_error(int n, ImplicitMatrix &a, std::vector<float> &b, aligned_vector &x);
+void check_error(int n, SparseMatrix &a, std::vector<float> &b, aligned_vector &x);
+void check_error(int n, StencilMatrix &a, std::vector<float> &b, aligned_vector &x);
+void check_error(int n, Matrix &a, RhsBatch &batch);
 
 // This function is used by the program par_jacobi.cpp (barriers) to compute: the time spent to execute subtasks and to
 // wait on the barrier by each thread
-void barrier_elapsed_time(std::vector<time_t> &wait_time, std::vector<time_t> &tot_wait_time,
+void barrier_elapsed_time(std::vector<padded<time_t>> &wait_time, std::vector<time_t> &tot_wait_time,
                           std::vector<time_t> &tot_ex_time);
 
 // This function is used by the program par_jacobi.cpp (barriers) to compute: elapsed execution time of the fastest
@@ -32,4 +113,6 @@ void barrier_stats(std::vector<time_t> &tot_wait_time, std::vector<time_t> &tot_
 // among all the threads, highest waiting time among all the threads, average waiting time of the threads, average ratio
 // execution time/(execution time + waiting time) of the threads, total time needed to refill the queue by the main
 // thread
-void thr_pool_stats(std::vector<time_t> &wait_time, std::vector<time_t> &ex_time, time_t &rf_queue);
\ No newline at end of file
+void thr_pool_stats(std::vector<time_t> &wait_time, std::vector<time_t> &ex_time, time_t &rf_queue);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef WS_DEQUE_H
+#define WS_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+// Chase-Lev work-stealing deque of task indices (Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+// Models"). Only the owner thread calls push() and pop(), which work on the bottom of the deque without any atomic
+// read-modify-write in the common case; any other thread calls steal(), which takes the task on the top with a single
+// CAS. The capacity is fixed: the deque is used for the chunks of one Jacobi iteration, whose number is known.
+class WSDeque {
+private:
+    // top and bottom are kept on different cache lines, so the thieves do not invalidate the line of the owner
+    alignas(64) std::atomic<std::int64_t> top;
+    alignas(64) std::atomic<std::int64_t> bottom;
+
+    alignas(64) std::unique_ptr<std::atomic<int>[]> buffer;
+    std::int64_t mask;
+
+public:
+    // Create a deque able to store at least capacity tasks
+    explicit WSDeque(int capacity) : top(0), bottom(0) {
+        std::int64_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        buffer = std::make_unique<std::atomic<int>[]>(size);
+        mask = size - 1;
+    }
+
+    WSDeque(const WSDeque&) = delete;
+    WSDeque& operator=(const WSDeque&) = delete;
+
+    // Insert a task on the bottom of the deque, called only by the owner (the deque must not be full)
+    void push(int task) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        buffer[b & mask].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Extract a task from the bottom of the deque, called only by the owner. Returns false if the deque is empty
+    bool pop(int &task) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // empty deque
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        task = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // last task, the owner races with the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Extract a task from the top of the deque, called by the thieves. Returns false if the deque is empty or if
+    // another thread took the task first
+    bool steal(int &task) {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return false;
+
+        task = buffer[t & mask].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+};
+
+#endif